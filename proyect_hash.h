@@ -0,0 +1,50 @@
+#ifndef PROYECT_HASH_H
+#define PROYECT_HASH_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Funciones comunes de las tablas hash con direccionamiento abierto (sondeo lineal)
+ * de las estadsticas de la Playlist y de la biblioteca.
+ */
+
+#define FNV_OFFSET 2166136261u
+#define FNV_PRIME 16777619u
+
+/**
+* @brief Contina un hash FNV-1a con los bytes de una cadena.
+*/
+static inline size_t Fnv_hash( size_t h, const char* str )
+{
+	for( ; *str; ++str )
+	{
+		h = ( h ^ (unsigned char) *str ) * FNV_PRIME;
+	}
+	return h;
+}
+
+static inline size_t String_hash( const char* str )
+{
+	return Fnv_hash( FNV_OFFSET, str );
+}
+
+/**
+* @brief Hash de una cancin por nombre y artista.
+*/
+static inline size_t Key_hash( const char name[], const char artist[] )
+{
+	size_t h = ( Fnv_hash( FNV_OFFSET, name ) ^ 0xff ) * FNV_PRIME; // separador, para que "ab"+"c" != "a"+"bc"
+	return Fnv_hash( h, artist );
+}
+
+/**
+* @brief Decide si al borrar la casilla hole se puede mover ah la de j (borrado con corrimiento
+* hacia atrs en sondeo lineal), segn la casilla home donde j quisiera estar.
+*/
+static inline bool Can_shift( size_t hole, size_t j, size_t home )
+{
+	return hole <= j ? ( home <= hole || home > j ) : ( home <= hole && home > j );
+}
+
+#endif
@@ -0,0 +1,837 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <stddef.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "proyect_journal.h"
+
+#define SNAP_MAGIC "PLSNAP01"
+#define SONG_MAX ( 4 + 1 + CHAR_TAM + 1 + CHAR_TAM )
+#define RECORD_HEAD ( 8 + 8 + 1 + 4 + 8 ) // Marco + lsn, op, arg, index
+
+/*
+ * Formato (enteros en el orden de bytes de la mquina):
+ *
+ * Snapshot: "PLSNAP01" | u64 lsn | u64 canciones | canciones... | u32 crc
+ * Cancin:  i32 duracin | u8 largo | nombre | u8 largo | artista
+ * Log:      registros  u32 largo | u32 crc | u64 lsn | u8 op | u32 arg | u64 index | [cancin]
+ *
+ * En ERASE_SET y MERGE index es el nmero de posiciones, y siguen index veces
+ * u64 posicin (ERASE_SET) o u64 posicin | cancin (MERGE), en orden creciente.
+ *
+ * Un registro incompleto o con crc invlido al final del log es una escritura que no
+ * termin antes de una cada: ah se deja de leer.
+ */
+
+static uint32_t crc_table[ 256 ];
+static pthread_once_t crc_once = PTHREAD_ONCE_INIT; // Varios Journal pueden escribir desde distintos hilos
+
+static void Crc32_init( void )
+{
+	for( uint32_t i = 0; i < 256; ++i )
+	{
+		uint32_t c = i;
+		for( int k = 0; k < 8; ++k )
+		{
+			c = ( c & 1 ) ? 0xedb88320u ^ ( c >> 1 ) : c >> 1;
+		}
+		crc_table[ i ] = c;
+	}
+}
+
+/**
+* @brief Calcula el CRC-32 (polinomio de IEEE) de un bloque de bytes.
+*/
+static uint32_t Crc32( const unsigned char* data, size_t len )
+{
+	pthread_once( &crc_once, Crc32_init );
+	
+	uint32_t crc = 0xffffffffu;
+	for( size_t i = 0; i < len; ++i )
+	{
+		crc = crc_table[ ( crc ^ data[ i ] ) & 0xff ] ^ ( crc >> 8 );
+	}
+	return crc ^ 0xffffffffu;
+}
+
+static char* Path_with( const char path[], const char suffix[] )
+{
+	char* p = (char*) malloc( strlen( path ) + strlen( suffix ) + 1 );
+	assert( p );
+	strcpy( p, path );
+	strcat( p, suffix );
+	return p;
+}
+
+static bool Write_all( int fd, const unsigned char* data, size_t len )
+{
+	while( len > 0 )
+	{
+		ssize_t n = write( fd, data, len );
+		if( n < 0 )
+		{
+			if( errno == EINTR ) continue;
+			return false;
+		}
+		data += n;
+		len -= (size_t) n;
+	}
+	return true;
+}
+
+/**
+* @brief Sincroniza el directorio que contiene a un archivo, para que un rename sobreviva a una cada.
+*/
+static bool Fsync_dir( const char file_path[] )
+{
+	char* dir = Path_with( file_path, "" );
+	char* slash = strrchr( dir, '/' );
+	if( slash == NULL )
+	{
+		strcpy( dir, "." );
+	}
+	else if( slash == dir )
+	{
+		dir[ 1 ] = '\0';
+	}
+	else
+	{
+		*slash = '\0';
+	}
+	
+	int fd = open( dir, O_RDONLY );
+	free( dir );
+	if( fd < 0 )
+	{
+		return false;
+	}
+	bool ok = fsync( fd ) == 0;
+	close( fd );
+	return ok;
+}
+
+/**
+* @brief Lee un archivo completo.
+*
+* @return El contenido (se libera con free), o NULL si no existe o no se pudo leer;
+* en ese caso missing indica si simplemente no exista.
+*/
+static unsigned char* Read_file( const char path[], size_t* len, bool* missing )
+{
+	*len = 0;
+	*missing = false;
+	
+	FILE* f = fopen( path, "rb" );
+	if( f == NULL )
+	{
+		*missing = ( errno == ENOENT );
+		return NULL;
+	}
+	
+	size_t cap = 4096;
+	unsigned char* data = (unsigned char*) malloc( cap );
+	assert( data );
+	size_t n;
+	while( ( n = fread( data + *len, 1, cap - *len, f ) ) > 0 )
+	{
+		*len += n;
+		if( *len == cap )
+		{
+			cap *= 2;
+			data = (unsigned char*) realloc( data, cap );
+			assert( data );
+		}
+	}
+	bool ok = !ferror( f );
+	fclose( f );
+	if( !ok )
+	{
+		free( data );
+		return NULL;
+	}
+	return data;
+}
+
+static unsigned char* Put( unsigned char* p, const void* src, size_t n )
+{
+	memcpy( p, src, n );
+	return p + n;
+}
+
+static unsigned char* Put_song( unsigned char* p, const Song* s )
+{
+	uint8_t name_len = (uint8_t) strnlen( s->name, CHAR_TAM - 1 );
+	uint8_t artist_len = (uint8_t) strnlen( s->artist, CHAR_TAM - 1 );
+	int32_t duration = s->duration;
+	
+	p = Put( p, &duration, sizeof( duration ) );
+	p = Put( p, &name_len, 1 );
+	p = Put( p, s->name, name_len );
+	p = Put( p, &artist_len, 1 );
+	return Put( p, s->artist, artist_len );
+}
+
+/**
+* @brief Lee una cancin de un bloque de bytes.
+*
+* @return Un apuntador despus de la cancin, o NULL si no cabe en [p, end).
+*/
+static const unsigned char* Get_song( const unsigned char* p, const unsigned char* end, Song* s )
+{
+	int32_t duration;
+	uint8_t len;
+	memset( s, 0, sizeof( Song ) );
+	
+	if( end - p < (ptrdiff_t) sizeof( duration ) + 1 ) return NULL;
+	memcpy( &duration, p, sizeof( duration ) );
+	p += sizeof( duration );
+	s->duration = duration;
+	
+	len = *p++;
+	if( len >= CHAR_TAM || end - p < len + 1 ) return NULL;
+	memcpy( s->name, p, len );
+	p += len;
+	
+	len = *p++;
+	if( len >= CHAR_TAM || end - p < len ) return NULL;
+	memcpy( s->artist, p, len );
+	return p + len;
+}
+
+/**
+* @brief Serializa la Playlist completa como snapshot.
+*
+* @return El snapshot (se libera con free).
+*/
+static unsigned char* Serialize_snapshot( Playlist* playlist, uint64_t lsn, size_t* len )
+{
+	size_t cap = 8 + 8 + 8 + playlist->len * SONG_MAX + 4;
+	unsigned char* data = (unsigned char*) malloc( cap );
+	assert( data );
+	
+	uint64_t count = playlist->len;
+	unsigned char* p = Put( data, SNAP_MAGIC, 8 );
+	p = Put( p, &lsn, sizeof( lsn ) );
+	p = Put( p, &count, sizeof( count ) );
+	for( Node* it = playlist->first; it != NULL; it = it->next )
+	{
+		p = Put_song( p, it->song );
+	}
+	uint32_t crc = Crc32( data + 8, (size_t) ( p - data - 8 ) );
+	p = Put( p, &crc, sizeof( crc ) );
+	
+	*len = (size_t) ( p - data );
+	return data;
+}
+
+/**
+* @brief Escribe un snapshot de forma atmica: a un archivo temporal, fsync y rename.
+*/
+static bool Write_snapshot( const char snap_path[], const unsigned char* data, size_t len )
+{
+	char* tmp = Path_with( snap_path, ".tmp" );
+	bool ok = false;
+	
+	int fd = open( tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+	if( fd >= 0 )
+	{
+		ok = Write_all( fd, data, len ) && fsync( fd ) == 0;
+		ok = ( close( fd ) == 0 ) && ok;
+		ok = ok && rename( tmp, snap_path ) == 0 && Fsync_dir( snap_path );
+		if( !ok )
+		{
+			unlink( tmp );
+		}
+	}
+	free( tmp );
+	return ok;
+}
+
+/**
+* @brief Carga un snapshot en una Playlist vaca.
+*
+* @return true si se carg o si no exista; false si est daado o no se pudo leer.
+*/
+static bool Load_snapshot( const char snap_path[], Playlist* playlist, uint64_t* lsn )
+{
+	size_t len;
+	bool missing;
+	unsigned char* data = Read_file( snap_path, &len, &missing );
+	*lsn = 0;
+	if( data == NULL )
+	{
+		return missing;
+	}
+	
+	bool ok = false;
+	uint64_t count;
+	uint32_t crc;
+	if( len >= 8 + 8 + 8 + 4 && memcmp( data, SNAP_MAGIC, 8 ) == 0 )
+	{
+		memcpy( &crc, data + len - 4, sizeof( crc ) );
+		if( crc == Crc32( data + 8, len - 8 - 4 ) )
+		{
+			memcpy( lsn, data + 8, sizeof( *lsn ) );
+			memcpy( &count, data + 16, sizeof( count ) );
+			
+			const unsigned char* p = data + 24;
+			const unsigned char* end = data + len - 4;
+			Song s;
+			for( ; count > 0 && ( p = Get_song( p, end, &s ) ) != NULL; --count )
+			{
+				Insert_Song_back( playlist, s.duration, s.name, s.artist );
+			}
+			ok = ( count == 0 && p == end );
+		}
+	}
+	free( data );
+	return ok;
+}
+
+/**
+* @brief Devuelve el nodo de la posicin i, caminando desde el extremo ms cercano.
+*/
+static Node* Node_at( Playlist* playlist, size_t i )
+{
+	Node* it;
+	if( i < playlist->len / 2 )
+	{
+		for( it = playlist->first; i > 0; --i ) it = it->next;
+	}
+	else
+	{
+		for( it = playlist->last, i = playlist->len - 1 - i; i > 0; --i ) it = it->prev;
+	}
+	return it;
+}
+
+/**
+* @brief Vuelve a aplicar una modificacin registrada en el log.
+*
+* @return false si el registro no tiene sentido para la Playlist actual.
+*/
+static bool Apply( Playlist* playlist, Playlist_op op, size_t index, uint32_t arg, Song* s )
+{
+	switch( op )
+	{
+		case PLAYLIST_OP_INSERT_FRONT:
+			Insert_Song_front( playlist, s->duration, s->name, s->artist );
+			return true;
+		
+		case PLAYLIST_OP_INSERT_BACK:
+			Insert_Song_back( playlist, s->duration, s->name, s->artist );
+			return true;
+		
+		case PLAYLIST_OP_INSERT_AT:
+			if( index > playlist->len ) return false;
+			if( index == 0 )
+			{
+				Insert_Song_front( playlist, s->duration, s->name, s->artist );
+			}
+			else
+			{
+				playlist->cursor = Node_at( playlist, index - 1 );
+				Insert_Song( playlist, s->duration, s->name, s->artist );
+			}
+			return true;
+		
+		case PLAYLIST_OP_ERASE_FRONT:
+			if( playlist->len == 0 ) return false;
+			Erase_Song_front( playlist );
+			playlist->cursor = playlist->first;
+			return true;
+		
+		case PLAYLIST_OP_ERASE_BACK:
+			if( playlist->len == 0 ) return false;
+			Erase_Song_back( playlist );
+			playlist->cursor = playlist->first;
+			return true;
+		
+		case PLAYLIST_OP_ERASE_AT:
+			if( index >= playlist->len ) return false;
+			playlist->cursor = Node_at( playlist, index );
+			Erase_Song( playlist );
+			return true;
+		
+		case PLAYLIST_OP_SORT:
+			if( index > playlist->len ) return false;
+			switch( arg )
+			{
+				case SONG_KEY_DURATION: Playlist_ordered_duration( playlist, index ); return true;
+				case SONG_KEY_NAME:     Playlist_ordered_name( playlist, index );     return true;
+				case SONG_KEY_ARTIST:   Playlist_ordered_artist( playlist, index );   return true;
+			}
+			return false;
+		
+		case PLAYLIST_OP_SHUFFLE:
+			Playlist_shuffle_spread( playlist, arg );
+			return true;
+		
+		case PLAYLIST_OP_CLEAR:
+			Make_Playlist_Empty( playlist );
+			return true;
+		
+		case PLAYLIST_OP_ERASE_SET:
+		case PLAYLIST_OP_MERGE:
+			return false; // van por Apply_batch
+	}
+	return false;
+}
+
+typedef struct
+{
+	const unsigned char* next; // Siguiente posicin (u64) del registro
+	const unsigned char* end;
+	size_t pos;                // Posicin de la cancin que se est viendo
+} Erase_set;
+
+static bool Erase_set_pred( const Song* song, void* ctx )
+{
+	(void) song;
+	Erase_set* e = (Erase_set*) ctx;
+	uint64_t target = 0;
+	if( e->next < e->end )
+	{
+		memcpy( &target, e->next, 8 );
+	}
+	bool hit = e->next < e->end && target == e->pos;
+	if( hit )
+	{
+		e->next += 8;
+	}
+	++e->pos;
+	return hit;
+}
+
+/**
+* @brief Vuelve a aplicar un ERASE_SET o un MERGE en un solo recorrido de la Playlist.
+*
+* @param r El contenido del registro despus de index.
+*
+* @return false si el registro est mal formado o no tiene sentido para la Playlist actual.
+*/
+static bool Apply_batch( Playlist* playlist, Playlist_op op, size_t count, const unsigned char* r, const unsigned char* r_end )
+{
+	uint64_t pos, prev_pos = 0;
+	
+	if( op == PLAYLIST_OP_ERASE_SET )
+	{
+		if( count == 0 || (size_t) ( r_end - r ) != count * 8 ) return false;
+		for( const unsigned char* q = r; q < r_end; q += 8 )
+		{
+			memcpy( &pos, q, 8 );
+			if( pos >= playlist->len || ( q > r && pos <= prev_pos ) ) return false;
+			prev_pos = pos;
+		}
+		
+		Erase_set e = { r, r_end, 0 };
+		Playlist_remove_if( playlist, Erase_set_pred, &e );
+		playlist->cursor = playlist->first;
+		return true;
+	}
+	
+	// MERGE: se avanza por la Playlist y se inserta cada cancin al llegar a su posicin
+	Node* prev = NULL;  // Nodo de la posicin i - 1
+	size_t i = 0;
+	Song s;
+	for( size_t j = 0; j < count; ++j )
+	{
+		if( r_end - r < 8 ) return false;
+		memcpy( &pos, r, 8 );
+		r = Get_song( r + 8, r_end, &s );
+		if( r == NULL || ( j > 0 && pos <= prev_pos ) ) return false;
+		prev_pos = pos;
+		
+		for( ; i < pos; ++i )
+		{
+			prev = ( prev == NULL ) ? playlist->first : prev->next;
+			if( prev == NULL ) return false;
+		}
+		if( prev == NULL )
+		{
+			Insert_Song_front( playlist, s.duration, s.name, s.artist );
+			prev = playlist->first;
+		}
+		else
+		{
+			playlist->cursor = prev;
+			Insert_Song( playlist, s.duration, s.name, s.artist );
+			prev = playlist->cursor;
+		}
+		++i;
+	}
+	playlist->cursor = playlist->first;
+	return r == r_end;
+}
+
+/**
+* @brief Aplica los registros de un log posteriores a after_lsn.
+*
+* @return false si no se pudo leer o si un registro vlido no se pudo aplicar.
+*/
+static bool Replay_log( const char log_path[], Playlist* playlist, uint64_t after_lsn, uint64_t* last_lsn )
+{
+	size_t len;
+	bool missing;
+	unsigned char* data = Read_file( log_path, &len, &missing );
+	if( data == NULL )
+	{
+		return missing;
+	}
+	
+	bool ok = true;
+	const unsigned char* p = data;
+	const unsigned char* end = data + len;
+	while( ok && end - p >= 8 )
+	{
+		uint32_t rec_len, crc;
+		memcpy( &rec_len, p, sizeof( rec_len ) );
+		memcpy( &crc, p + 4, sizeof( crc ) );
+		if( rec_len < 8 + 1 + 4 + 8 || (size_t) ( end - p - 8 ) < rec_len || Crc32( p + 8, rec_len ) != crc )
+		{
+			break; // cola incompleta de una escritura interrumpida
+		}
+		
+		const unsigned char* r = p + 8;
+		const unsigned char* r_end = r + rec_len;
+		uint64_t lsn, index;
+		uint8_t op;
+		uint32_t arg;
+		Song s;
+		memset( &s, 0, sizeof( s ) );
+		
+		memcpy( &lsn, r, 8 );
+		op = r[ 8 ];
+		memcpy( &arg, r + 9, 4 );
+		memcpy( &index, r + 13, 8 );
+		r += 21;
+		if( op == PLAYLIST_OP_INSERT_FRONT || op == PLAYLIST_OP_INSERT_BACK || op == PLAYLIST_OP_INSERT_AT )
+		{
+			ok = Get_song( r, r_end, &s ) != NULL;
+		}
+		
+		if( ok && lsn > after_lsn )
+		{
+			if( op == PLAYLIST_OP_ERASE_SET || op == PLAYLIST_OP_MERGE )
+			{
+				ok = Apply_batch( playlist, (Playlist_op) op, (size_t) index, r, r_end );
+			}
+			else
+			{
+				ok = Apply( playlist, (Playlist_op) op, (size_t) index, arg, &s );
+			}
+			*last_lsn = lsn;
+		}
+		p = r_end;
+	}
+	free( data );
+	return ok;
+}
+
+/**
+* @brief Recibe las modificaciones de la Playlist y las agrega al buffer del log.
+*/
+static void Journal_hook( void* ctx, const Playlist_change* change )
+{
+	Journal* this = (Journal*) ctx;
+	
+	size_t max = RECORD_HEAD + SONG_MAX;
+	if( change->op == PLAYLIST_OP_ERASE_SET )
+	{
+		max = RECORD_HEAD + change->index * 8;
+	}
+	else if( change->op == PLAYLIST_OP_MERGE )
+	{
+		max = RECORD_HEAD + change->index * ( 8 + SONG_MAX );
+	}
+	if( this->buffer_len + max > this->buffer_cap )
+	{
+		Journal_commit( this );
+		if( max > this->buffer_cap ) // un solo registro ms grande que el buffer
+		{
+			this->buffer_cap = max;
+			this->buffer = (unsigned char*) realloc( this->buffer, this->buffer_cap );
+			assert( this->buffer );
+		}
+	}
+	
+	uint64_t lsn = ++this->lsn;
+	uint8_t op = (uint8_t) change->op;
+	uint32_t arg = change->arg;
+	uint64_t index = change->index;
+	
+	unsigned char* frame = this->buffer + this->buffer_len;
+	unsigned char* p = frame + 8;
+	p = Put( p, &lsn, sizeof( lsn ) );
+	p = Put( p, &op, 1 );
+	p = Put( p, &arg, sizeof( arg ) );
+	p = Put( p, &index, sizeof( index ) );
+	if( change->song != NULL )
+	{
+		p = Put_song( p, change->song );
+	}
+	for( size_t i = 0; change->positions != NULL && i < change->index; ++i )
+	{
+		uint64_t pos = change->positions[ i ];
+		p = Put( p, &pos, sizeof( pos ) );
+		if( change->songs != NULL )
+		{
+			p = Put_song( p, change->songs[ i ] );
+		}
+	}
+	
+	uint32_t rec_len = (uint32_t) ( p - frame - 8 );
+	uint32_t crc = Crc32( frame + 8, rec_len );
+	memcpy( frame, &rec_len, sizeof( rec_len ) );
+	memcpy( frame + 4, &crc, sizeof( crc ) );
+	this->buffer_len += (size_t) ( p - frame );
+	
+	if( ++this->pending >= this->group_size )
+	{
+		Journal_commit( this );
+	}
+}
+
+/**
+* @brief Hilo compactador: escribe el snapshot y borra el log que ste ya contiene.
+*/
+static void* Compactor( void* arg )
+{
+	Journal* this = (Journal*) arg;
+	
+	bool ok = Write_snapshot( this->snap_path, this->snap_buffer, this->snap_len );
+	if( ok )
+	{
+		ok = ( unlink( this->old_log_path ) == 0 || errno == ENOENT ) && Fsync_dir( this->old_log_path );
+	}
+	
+	pthread_mutex_lock( &this->lock );
+	this->compact_ok = ok;
+	this->compact_done = true;
+	pthread_mutex_unlock( &this->lock );
+	return NULL;
+}
+
+/**
+* @brief Espera al hilo compactador, si hay uno, y libera su snapshot.
+*
+* @return false si la compactacin fall.
+*/
+static bool Join_compactor( Journal* this )
+{
+	if( !this->compacting )
+	{
+		return true;
+	}
+	pthread_join( this->compactor, NULL );
+	free( this->snap_buffer );
+	this->snap_buffer = NULL;
+	this->compacting = false;
+	if( !this->compact_ok )
+	{
+		this->failed = true; // el log viejo sigue siendo necesario y el prximo rename lo pisara
+	}
+	return this->compact_ok;
+}
+
+static void Free_journal( Journal* this )
+{
+	free( this->snap_path );
+	free( this->log_path );
+	free( this->old_log_path );
+	free( this->buffer );
+	free( this );
+}
+
+/**
+* @brief Abre (o crea) el journal de una Playlist y la recupera: snapshot + registros del log.
+*
+* A partir de aqu cada Insert_Song*, Erase_Song*, Remove_Song, ordenamiento, etc. de la
+* Playlist se agrega al log. Los registros se escriben y se sincronizan con fsync en grupos
+* de group_size (group commit): ante una cada se pierden a lo ms los del ltimo grupo.
+*
+* Costo: Playlist_remove_if y Playlist_merge se registran como un solo registro que se
+* recupera en un recorrido. En cambio, Insert_Song y Erase_Song a mitad de la lista cuestan
+* O(posicin del cursor) ms mientras hay journal (hay que calcular la posicin que se
+* registra), y cada uno de esos registros cuesta O(n) al recuperarlo. Para ediciones masivas
+* en listas grandes conviene Playlist_remove_if, o Journal_compact de vez en cuando.
+*
+* @param path Ruta base; se usan <path>.snap, <path>.log y <path>.log.old.
+* @param playlist Una Playlist vaca donde se recupera el contenido.
+* @param group_size Cada cuntos registros se hace fsync; 1 sincroniza cada modificacin.
+*
+* @return Una referencia al journal, o NULL si hubo un error de E/S o los archivos estn daados
+* (en ese caso la Playlist queda vaca).
+* @post Hay que cerrar el journal con Journal_close antes de destruir la Playlist.
+*/
+Journal* Journal_open( const char path[], Playlist* playlist, size_t group_size )
+{
+	assert( path );
+	assert( playlist );
+	assert( Playlist_Is_empty( playlist ) );
+	assert( playlist->hook == NULL );
+	
+	Journal* this = (Journal*) calloc( 1, sizeof( Journal ) );
+	assert( this );
+	this->snap_path = Path_with( path, ".snap" );
+	this->log_path = Path_with( path, ".log" );
+	this->old_log_path = Path_with( path, ".log.old" );
+	this->playlist = playlist;
+	this->group_size = group_size > 0 ? group_size : 1;
+	this->buffer_cap = JOURNAL_BUFFER_TAM;
+	this->buffer = (unsigned char*) malloc( this->buffer_cap );
+	assert( this->buffer );
+	this->log_fd = -1;
+	
+	uint64_t snap_lsn;
+	bool ok = Load_snapshot( this->snap_path, playlist, &snap_lsn );
+	this->lsn = snap_lsn;
+	ok = ok && Replay_log( this->old_log_path, playlist, snap_lsn, &this->lsn );
+	ok = ok && Replay_log( this->log_path, playlist, snap_lsn, &this->lsn );
+	
+	// Se deja un snapshot nuevo con todo lo recuperado y un log vaco
+	if( ok )
+	{
+		size_t len;
+		unsigned char* snap = Serialize_snapshot( playlist, this->lsn, &len );
+		ok = Write_snapshot( this->snap_path, snap, len );
+		free( snap );
+	}
+	ok = ok && ( unlink( this->old_log_path ) == 0 || errno == ENOENT );
+	if( ok )
+	{
+		this->log_fd = open( this->log_path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644 );
+		ok = this->log_fd >= 0 && Fsync_dir( this->log_path );
+	}
+	
+	if( !ok )
+	{
+		if( this->log_fd >= 0 ) close( this->log_fd );
+		Make_Playlist_Empty( playlist );
+		Free_journal( this );
+		return NULL;
+	}
+	
+	pthread_mutex_init( &this->lock, NULL );
+	Playlist_set_hook( playlist, Journal_hook, this );
+	return this;
+}
+
+/**
+* @brief Escribe al log los registros pendientes y los sincroniza con fsync.
+*
+* @param this Un journal.
+*
+* @return false si alguna vez fall una escritura; desde ese momento el log no es confiable.
+*/
+bool Journal_commit( Journal* this )
+{
+	assert( this );
+	
+	if( this->buffer_len > 0 && !this->failed )
+	{
+		if( !Write_all( this->log_fd, this->buffer, this->buffer_len ) || fsync( this->log_fd ) != 0 )
+		{
+			this->failed = true;
+		}
+	}
+	this->buffer_len = 0;
+	this->pending = 0;
+	if( this->buffer_cap > JOURNAL_BUFFER_TAM )
+	{
+		this->buffer_cap = JOURNAL_BUFFER_TAM;
+		this->buffer = (unsigned char*) realloc( this->buffer, this->buffer_cap );
+		assert( this->buffer );
+	}
+	return !this->failed;
+}
+
+/**
+* @brief Inicia la compactacin en segundo plano: el log actual se cambia por uno nuevo y un
+* hilo escribe un snapshot de la Playlist, tras lo cual el log viejo se borra.
+*
+* La Playlist se puede seguir modificando mientras tanto; slo la serializacin (una copia
+* en memoria) se hace en el hilo que llama.
+*
+* @param this Un journal.
+*
+* @return true si se inici; false si todava hay otra en curso o hubo un error de E/S.
+*/
+bool Journal_compact( Journal* this )
+{
+	assert( this );
+	
+	if( !Journal_commit( this ) )
+	{
+		return false;
+	}
+	
+	pthread_mutex_lock( &this->lock );
+	bool busy = this->compacting && !this->compact_done;
+	pthread_mutex_unlock( &this->lock );
+	if( busy || !Join_compactor( this ) )
+	{
+		return false;
+	}
+	
+	close( this->log_fd );
+	this->log_fd = -1;
+	if( rename( this->log_path, this->old_log_path ) != 0 )
+	{
+		this->failed = true;
+		return false;
+	}
+	this->log_fd = open( this->log_path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644 );
+	if( this->log_fd < 0 || !Fsync_dir( this->log_path ) )
+	{
+		this->failed = true;
+		return false;
+	}
+	
+	this->snap_buffer = Serialize_snapshot( this->playlist, this->lsn, &this->snap_len );
+	this->compacting = true;
+	this->compact_done = false;
+	if( pthread_create( &this->compactor, NULL, Compactor, this ) != 0 )
+	{
+		Compactor( this ); // sin hilo, se hace aqu mismo
+		this->compacting = false;
+		free( this->snap_buffer );
+		this->snap_buffer = NULL;
+		if( !this->compact_ok )
+		{
+			this->failed = true;
+		}
+		return this->compact_ok;
+	}
+	return true;
+}
+
+/**
+* @brief Escribe lo pendiente, espera a la compactacin en curso y desliga el journal de la Playlist.
+*
+* @param this Un journal.
+*
+* @return true si todo lo registrado qued en disco.
+*/
+bool Journal_close( Journal** this )
+{
+	assert( *this );
+	Journal* j = *this;
+	
+	Journal_commit( j );
+	Join_compactor( j );
+	bool ok = !j->failed;
+	
+	Playlist_set_hook( j->playlist, NULL, NULL );
+	if( j->log_fd >= 0 )
+	{
+		ok = ( close( j->log_fd ) == 0 ) && ok;
+	}
+	pthread_mutex_destroy( &j->lock );
+	Free_journal( j );
+	
+	*this = NULL;
+	return ok;
+}
@@ -0,0 +1,40 @@
+#ifndef PROYECT_JOURNAL_H
+#define PROYECT_JOURNAL_H
+
+#include <pthread.h>
+#include "proyect_playlist.h"
+
+#define JOURNAL_BUFFER_TAM 65536 // Bytes que se acumulan antes de escribir al log
+
+typedef struct
+{
+	char* snap_path;       // <path>.snap: la Playlist completa hasta snap_lsn
+	char* log_path;        // <path>.log: modificaciones posteriores
+	char* old_log_path;    // <path>.log.old: log que se est compactando
+	int log_fd;
+	
+	Playlist* playlist;
+	uint64_t lsn;          // Nmero de secuencia del ltimo registro
+	
+	unsigned char* buffer; // Registros que an no se escriben
+	size_t buffer_len;
+	size_t buffer_cap;     // JOURNAL_BUFFER_TAM, salvo mientras hay un registro ms grande
+	size_t pending;        // Registros en el buffer
+	size_t group_size;     // Cada cuntos registros se hace write + fsync
+	bool failed;           // Hubo un error de E/S; ya no se garantiza nada
+	
+	pthread_t compactor;
+	pthread_mutex_t lock;
+	bool compacting;
+	bool compact_done;
+	bool compact_ok;
+	unsigned char* snap_buffer; // Snapshot serializado que escribe el hilo compactador
+	size_t snap_len;
+} Journal;
+
+Journal* Journal_open( const char path[], Playlist* playlist, size_t group_size );
+bool     Journal_commit( Journal* this );
+bool     Journal_compact( Journal* this );
+bool     Journal_close( Journal** this );
+
+#endif
@@ -0,0 +1,603 @@
+#include "proyect_library.h"
+#include "proyect_hash.h"
+
+/*
+ * Cada cancin existe una sola vez en el catlogo y las Playlist guardan slo su Song_id,
+ * as que crear, copiar o borrar una Playlist no copia ni libera canciones. Para saber en
+ * qu Playlist aparece una cancin, cada cancin guarda la lista de sus Playlist (owners)
+ * y la tabla pairs cuenta cuntas veces aparece en cada una.
+ */
+
+static void Id_vec_push( Id_vec* v, uint32_t id )
+{
+	if( v->len == v->cap )
+	{
+		v->cap = v->cap ? v->cap * 2 : 8;
+		v->data = (uint32_t*) realloc( v->data, v->cap * sizeof( uint32_t ) );
+		assert( v->data );
+	}
+	v->data[ v->len++ ] = id;
+}
+
+static void Id_vec_free( Id_vec* v )
+{
+	free( v->data );
+	v->data = NULL;
+	v->len = v->cap = 0;
+}
+
+static size_t Pair_hash( Song_id song, List_id list )
+{
+	uint64_t k = ( (uint64_t) song << 32 ) | list;
+	k ^= k >> 33;
+	k *= 0xff51afd7ed558ccdull;
+	k ^= k >> 33;
+	return (size_t) k;
+}
+
+/* ---------- ndice nombre+artista -> Song_id ---------- */
+
+static size_t Index_home( Library* this, Song_id id )
+{
+	const Song* s = &this->songs[ id ].song;
+	return Key_hash( s->name, s->artist ) & ( this->index_cap - 1 );
+}
+
+/**
+* @brief Busca la casilla de una cancin en el ndice.
+*
+* @return La casilla con su Song_id, o la casilla vaca donde ira.
+*/
+static size_t Index_slot( Library* this, const char name[], const char artist[] )
+{
+	size_t mask = this->index_cap - 1;
+	size_t i = Key_hash( name, artist ) & mask;
+	while( this->index[ i ] != LIBRARY_NIL )
+	{
+		const Song* s = &this->songs[ this->index[ i ] ].song;
+		if( strcmp( s->name, name ) == 0 && strcmp( s->artist, artist ) == 0 )
+		{
+			break;
+		}
+		i = ( i + 1 ) & mask;
+	}
+	return i;
+}
+
+static void Index_grow( Library* this )
+{
+	Song_id* old = this->index;
+	size_t old_cap = this->index_cap;
+	
+	this->index_cap = old_cap ? old_cap * 2 : 64;
+	this->index = (Song_id*) malloc( this->index_cap * sizeof( Song_id ) );
+	assert( this->index );
+	memset( this->index, 0xff, this->index_cap * sizeof( Song_id ) ); // LIBRARY_NIL
+	
+	for( size_t i = 0; i < old_cap; ++i )
+	{
+		if( old[ i ] != LIBRARY_NIL )
+		{
+			size_t j = Index_home( this, old[ i ] );
+			while( this->index[ j ] != LIBRARY_NIL )
+			{
+				j = ( j + 1 ) & ( this->index_cap - 1 );
+			}
+			this->index[ j ] = old[ i ];
+		}
+	}
+	free( old );
+}
+
+static void Index_erase( Library* this, size_t hole )
+{
+	size_t mask = this->index_cap - 1;
+	for( size_t j = ( hole + 1 ) & mask; this->index[ j ] != LIBRARY_NIL; j = ( j + 1 ) & mask )
+	{
+		if( Can_shift( hole, j, Index_home( this, this->index[ j ] ) ) )
+		{
+			this->index[ hole ] = this->index[ j ];
+			hole = j;
+		}
+	}
+	this->index[ hole ] = LIBRARY_NIL;
+	--this->index_used;
+}
+
+/* ---------- Tabla (cancin, Playlist) -> apariciones ---------- */
+
+static size_t Pair_slot( Library* this, Song_id song, List_id list )
+{
+	size_t mask = this->pairs_cap - 1;
+	size_t i = Pair_hash( song, list ) & mask;
+	while( this->pairs[ i ].used && ( this->pairs[ i ].song != song || this->pairs[ i ].list != list ) )
+	{
+		i = ( i + 1 ) & mask;
+	}
+	return i;
+}
+
+static void Pairs_grow( Library* this )
+{
+	Library_pair* old = this->pairs;
+	size_t old_cap = this->pairs_cap;
+	
+	this->pairs_cap = old_cap ? old_cap * 2 : 64;
+	this->pairs = (Library_pair*) calloc( this->pairs_cap, sizeof( Library_pair ) );
+	assert( this->pairs );
+	
+	for( size_t i = 0; i < old_cap; ++i )
+	{
+		if( old[ i ].used )
+		{
+			this->pairs[ Pair_slot( this, old[ i ].song, old[ i ].list ) ] = old[ i ];
+		}
+	}
+	free( old );
+}
+
+static void Pairs_erase( Library* this, size_t hole )
+{
+	size_t mask = this->pairs_cap - 1;
+	for( size_t j = ( hole + 1 ) & mask; this->pairs[ j ].used; j = ( j + 1 ) & mask )
+	{
+		if( Can_shift( hole, j, Pair_hash( this->pairs[ j ].song, this->pairs[ j ].list ) & mask ) )
+		{
+			this->pairs[ hole ] = this->pairs[ j ];
+			hole = j;
+		}
+	}
+	this->pairs[ hole ].used = false;
+	--this->pairs_used;
+}
+
+/**
+* @brief Registra una aparicin ms de la cancin en la Playlist.
+*/
+static void Add_membership( Library* this, Song_id song, List_id list )
+{
+	if( ( this->pairs_used + 1 ) * 10 > this->pairs_cap * 7 )
+	{
+		Pairs_grow( this );
+	}
+	
+	Library_pair* p = &this->pairs[ Pair_slot( this, song, list ) ];
+	if( !p->used )
+	{
+		Id_vec* owners = &this->songs[ song ].owners;
+		p->used = true;
+		p->song = song;
+		p->list = list;
+		p->count = 0;
+		p->pos = (uint32_t) owners->len;
+		Id_vec_push( owners, list );
+		++this->pairs_used;
+	}
+	++p->count;
+}
+
+/**
+* @brief Saca a list de los owners de la cancin en O(1): la ltima ocupa su lugar.
+*/
+static void Drop_owner( Library* this, Song_id song, uint32_t pos )
+{
+	Id_vec* owners = &this->songs[ song ].owners;
+	List_id moved = owners->data[ --owners->len ];
+	if( pos < owners->len )
+	{
+		owners->data[ pos ] = moved;
+		this->pairs[ Pair_slot( this, song, moved ) ].pos = pos;
+	}
+}
+
+/**
+* @brief Quita una aparicin de la cancin en la Playlist.
+*/
+static void Remove_membership( Library* this, Song_id song, List_id list )
+{
+	size_t i = Pair_slot( this, song, list );
+	assert( this->pairs[ i ].used );
+	
+	if( --this->pairs[ i ].count == 0 )
+	{
+		uint32_t pos = this->pairs[ i ].pos;
+		Pairs_erase( this, i );
+		Drop_owner( this, song, pos );
+	}
+}
+
+static Library_list* Get_list( Library* this, List_id list )
+{
+	assert( list < this->lists_len );
+	assert( this->lists[ list ].alive );
+	return &this->lists[ list ];
+}
+
+/**
+* @brief Crea una biblioteca vaca: un catlogo de canciones y las Playlist que lo usan.
+*
+* @return Una referencia a la nueva biblioteca.
+*/
+Library* New_Library()
+{
+	Library* lib = (Library*) calloc( 1, sizeof( Library ) );
+	if( lib )
+	{
+		Index_grow( lib );
+		Pairs_grow( lib );
+	}
+	return lib;
+}
+
+/**
+* @brief Destruye una biblioteca con todo su catlogo y sus Playlist.
+*
+* @param this Una biblioteca.
+*/
+void Delete_Library( Library** this )
+{
+	assert( *this );
+	Library* lib = *this;
+	
+	for( size_t i = 0; i < lib->songs_len; ++i )
+	{
+		Id_vec_free( &lib->songs[ i ].owners );
+	}
+	for( size_t i = 0; i < lib->lists_len; ++i )
+	{
+		Id_vec_free( &lib->lists[ i ].ids );
+	}
+	Id_vec_free( &lib->free_songs );
+	Id_vec_free( &lib->free_lists );
+	free( lib->songs );
+	free( lib->lists );
+	free( lib->index );
+	free( lib->pairs );
+	free( lib );
+	
+	*this = NULL;
+}
+
+/**
+* @brief Agrega una cancin al catlogo. Si ya hay una con el mismo nombre y artista, devuelve esa.
+*
+* @param this Una biblioteca.
+* @param duration Duracin de la cancin.
+* @param name Nombre de la cancin.
+* @param artist Nombre del artista.
+*
+* @return El Song_id de la cancin.
+*/
+Song_id Library_add_song( Library* this, int duration, char name[], char artist[] )
+{
+	assert( this );
+	
+	Song key;
+	memset( &key, 0, sizeof( key ) );
+	strncpy( key.name, name, CHAR_TAM - 1 );
+	strncpy( key.artist, artist, CHAR_TAM - 1 );
+	
+	size_t slot = Index_slot( this, key.name, key.artist );
+	if( this->index[ slot ] != LIBRARY_NIL )
+	{
+		return this->index[ slot ];
+	}
+	
+	Song_id id;
+	if( this->free_songs.len > 0 )
+	{
+		id = this->free_songs.data[ --this->free_songs.len ];
+	}
+	else
+	{
+		if( this->songs_len == this->songs_cap )
+		{
+			this->songs_cap = this->songs_cap ? this->songs_cap * 2 : 64;
+			this->songs = (Library_entry*) realloc( this->songs, this->songs_cap * sizeof( Library_entry ) );
+			assert( this->songs );
+		}
+		id = (Song_id) this->songs_len++;
+		memset( &this->songs[ id ].owners, 0, sizeof( Id_vec ) );
+	}
+	assert( id != LIBRARY_NIL );
+	
+	key.duration = duration;
+	this->songs[ id ].song = key;
+	this->songs[ id ].alive = true;
+	
+	if( ( this->index_used + 1 ) * 10 > this->index_cap * 7 )
+	{
+		Index_grow( this );
+		slot = Index_slot( this, key.name, key.artist );
+	}
+	this->index[ slot ] = id;
+	++this->index_used;
+	return id;
+}
+
+/**
+* @brief Busca una cancin en el catlogo por nombre y artista.
+*
+* @param this Una biblioteca.
+* @param name Nombre de la cancin.
+* @param artist Nombre del artista.
+*
+* @return El Song_id, o LIBRARY_NIL si no est.
+*/
+Song_id Library_find_song( Library* this, char name[], char artist[] )
+{
+	assert( this );
+	return this->index[ Index_slot( this, name, artist ) ];
+}
+
+/**
+* @brief Devuelve la cancin del catlogo con el Song_id dado.
+*
+* @param this Una biblioteca.
+* @param id Un Song_id vivo.
+*
+* @return La cancin; pertenece a la biblioteca.
+*/
+const Song* Library_song( Library* this, Song_id id )
+{
+	assert( this );
+	assert( id < this->songs_len && this->songs[ id ].alive );
+	return &this->songs[ id ].song;
+}
+
+/**
+* @brief Borra una cancin del catlogo y de todas las Playlist que la contienen.
+*
+* Slo se recorren las Playlist que la contienen, cada una una sola vez.
+*
+* @param this Una biblioteca.
+* @param id Un Song_id vivo; despus de esto puede reutilizarse para otra cancin.
+*
+* @return El nmero de apariciones que se quitaron.
+*/
+size_t Library_delete_song( Library* this, Song_id id )
+{
+	assert( this );
+	assert( id < this->songs_len && this->songs[ id ].alive );
+	
+	size_t removed = 0;
+	Id_vec* owners = &this->songs[ id ].owners;
+	for( size_t k = 0; k < owners->len; ++k )
+	{
+		List_id list = owners->data[ k ];
+		Id_vec* ids = &this->lists[ list ].ids;
+		
+		size_t kept = 0;
+		for( size_t i = 0; i < ids->len; ++i )
+		{
+			if( ids->data[ i ] != id )
+			{
+				ids->data[ kept++ ] = ids->data[ i ];
+			}
+		}
+		removed += ids->len - kept;
+		ids->len = kept;
+		
+		Pairs_erase( this, Pair_slot( this, id, list ) );
+	}
+	owners->len = 0;
+	
+	const Song* s = &this->songs[ id ].song;
+	Index_erase( this, Index_slot( this, s->name, s->artist ) );
+	this->songs[ id ].alive = false;
+	Id_vec_push( &this->free_songs, id );
+	return removed;
+}
+
+/**
+* @brief Crea una Playlist vaca dentro de la biblioteca.
+*
+* @param this Una biblioteca.
+*
+* @return El List_id de la nueva Playlist.
+*/
+List_id Library_new_playlist( Library* this )
+{
+	assert( this );
+	
+	List_id list;
+	if( this->free_lists.len > 0 )
+	{
+		list = this->free_lists.data[ --this->free_lists.len ];
+	}
+	else
+	{
+		if( this->lists_len == this->lists_cap )
+		{
+			this->lists_cap = this->lists_cap ? this->lists_cap * 2 : 64;
+			this->lists = (Library_list*) realloc( this->lists, this->lists_cap * sizeof( Library_list ) );
+			assert( this->lists );
+		}
+		list = (List_id) this->lists_len++;
+		memset( &this->lists[ list ].ids, 0, sizeof( Id_vec ) );
+	}
+	assert( list != LIBRARY_NIL );
+	
+	this->lists[ list ].ids.len = 0;
+	this->lists[ list ].alive = true;
+	return list;
+}
+
+/**
+* @brief Copia una Playlist de la biblioteca. Slo se copian los Song_id, no las canciones.
+*
+* @param this Una biblioteca.
+* @param list La Playlist original.
+*
+* @return El List_id de la copia.
+*/
+List_id Library_copy_playlist( Library* this, List_id list )
+{
+	assert( this );
+	Get_list( this, list );
+	
+	List_id copy = Library_new_playlist( this );
+	Id_vec* src = &this->lists[ list ].ids; // despus de new_playlist: lists pudo moverse
+	Id_vec* dst = &this->lists[ copy ].ids;
+	
+	if( src->len > 0 )
+	{
+		if( dst->cap < src->len )
+		{
+			dst->cap = src->len;
+			dst->data = (uint32_t*) realloc( dst->data, dst->cap * sizeof( uint32_t ) );
+			assert( dst->data );
+		}
+		memcpy( dst->data, src->data, src->len * sizeof( uint32_t ) );
+	}
+	dst->len = src->len;
+	
+	for( size_t i = 0; i < dst->len; ++i )
+	{
+		Add_membership( this, dst->data[ i ], copy );
+	}
+	return copy;
+}
+
+/**
+* @brief Borra una Playlist de la biblioteca. Las canciones siguen en el catlogo.
+*
+* @param this Una biblioteca.
+* @param list La Playlist a borrar; su List_id puede reutilizarse.
+*/
+void Library_delete_playlist( Library* this, List_id list )
+{
+	assert( this );
+	Library_list* l = Get_list( this, list );
+	
+	for( size_t i = 0; i < l->ids.len; ++i )
+	{
+		Remove_membership( this, l->ids.data[ i ], list );
+	}
+	l->ids.len = 0;
+	l->alive = false;
+	Id_vec_push( &this->free_lists, list );
+}
+
+/**
+* @brief Agrega una cancin del catlogo al final de una Playlist de la biblioteca.
+*
+* @param this Una biblioteca.
+* @param list Una Playlist.
+* @param id Un Song_id vivo.
+*/
+void Library_append( Library* this, List_id list, Song_id id )
+{
+	assert( this );
+	assert( id < this->songs_len && this->songs[ id ].alive );
+	
+	Id_vec_push( &Get_list( this, list )->ids, id );
+	Add_membership( this, id, list );
+}
+
+/**
+* @brief Quita la cancin de la posicin dada de una Playlist de la biblioteca.
+*
+* @param this Una biblioteca.
+* @param list Una Playlist.
+* @param index La posicin, empezando en 0.
+*/
+void Library_remove_at( Library* this, List_id list, size_t index )
+{
+	assert( this );
+	Id_vec* ids = &Get_list( this, list )->ids;
+	assert( index < ids->len );
+	
+	Remove_membership( this, ids->data[ index ], list );
+	memmove( ids->data + index, ids->data + index + 1, ( ids->len - index - 1 ) * sizeof( uint32_t ) );
+	--ids->len;
+}
+
+/**
+* @brief Devuelve el nmero de canciones de una Playlist de la biblioteca.
+*/
+size_t Library_playlist_len( Library* this, List_id list )
+{
+	assert( this );
+	return Get_list( this, list )->ids.len;
+}
+
+/**
+* @brief Devuelve el Song_id de la posicin dada de una Playlist de la biblioteca.
+*/
+Song_id Library_playlist_get( Library* this, List_id list, size_t index )
+{
+	assert( this );
+	Id_vec* ids = &Get_list( this, list )->ids;
+	assert( index < ids->len );
+	return ids->data[ index ];
+}
+
+/**
+* @brief Indica qu Playlist contienen una cancin.
+*
+* @param this Una biblioteca.
+* @param id Un Song_id vivo.
+* @param out Arreglo donde se dejan los List_id; puede ser NULL si max es 0.
+* @param max Tamao de out.
+*
+* @return El nmero total de Playlist que la contienen (puede ser mayor que max).
+*/
+size_t Library_playlists_with( Library* this, Song_id id, List_id out[], size_t max )
+{
+	assert( this );
+	assert( id < this->songs_len && this->songs[ id ].alive );
+	
+	Id_vec* owners = &this->songs[ id ].owners;
+	size_t n = owners->len < max ? owners->len : max;
+	if( n > 0 )
+	{
+		memcpy( out, owners->data, n * sizeof( List_id ) );
+	}
+	return owners->len;
+}
+
+/**
+* @brief Crea una Playlist de la biblioteca con las canciones de una Playlist normal.
+*
+* @param this Una biblioteca.
+* @param source La Playlist a importar; no se modifica.
+*
+* @return El List_id de la nueva Playlist.
+*/
+List_id Library_import( Library* this, Playlist* source )
+{
+	assert( this );
+	assert( source );
+	
+	List_id list = Library_new_playlist( this );
+	for( Node* it = source->first; it != NULL; it = it->next )
+	{
+		Song_id id = Library_add_song( this, it->song->duration, it->song->name, it->song->artist );
+		Library_append( this, list, id );
+	}
+	return list;
+}
+
+/**
+* @brief Crea una Playlist normal con las canciones de una Playlist de la biblioteca.
+*
+* @param this Una biblioteca.
+* @param list Una Playlist de la biblioteca.
+*
+* @return Una referencia a la nueva Playlist.
+*/
+Playlist* Library_materialize( Library* this, List_id list )
+{
+	assert( this );
+	Id_vec* ids = &Get_list( this, list )->ids;
+	
+	Playlist* result = New_Playlist();
+	assert( result );
+	for( size_t i = 0; i < ids->len; ++i )
+	{
+		Song* s = &this->songs[ ids->data[ i ] ].song;
+		Insert_Song_back( result, s->duration, s->name, s->artist );
+	}
+	return result;
+}
@@ -0,0 +1,83 @@
+#ifndef PROYECT_LIBRARY_H
+#define PROYECT_LIBRARY_H
+
+#include "proyect_playlist.h"
+
+#define LIBRARY_NIL UINT32_MAX
+
+typedef uint32_t Song_id;
+typedef uint32_t List_id;
+
+typedef struct
+{
+	uint32_t* data;
+	size_t len;
+	size_t cap;
+} Id_vec;
+
+typedef struct
+{
+	Song song;
+	bool alive;
+	Id_vec owners;            // Playlists distintas que contienen a la cancin
+} Library_entry;
+
+typedef struct
+{
+	Id_vec ids;               // La Playlist es una secuencia de Song_id
+	bool alive;
+} Library_list;
+
+typedef struct
+{
+	Song_id song;
+	List_id list;
+	uint32_t count;           // Veces que la cancin aparece en la Playlist
+	uint32_t pos;             // Posicin de list en owners de la cancin
+	bool used;
+} Library_pair;
+
+typedef struct
+{
+	Library_entry* songs;     // Catlogo: el Song_id es el ndice
+	size_t songs_len;
+	size_t songs_cap;
+	Id_vec free_songs;
+	
+	Song_id* index;           // Tabla hash nombre+artista -> Song_id
+	size_t index_cap;
+	size_t index_used;
+	
+	Library_pair* pairs;      // Tabla hash (cancin, Playlist) -> apariciones
+	size_t pairs_cap;
+	size_t pairs_used;
+	
+	Library_list* lists;
+	size_t lists_len;
+	size_t lists_cap;
+	Id_vec free_lists;
+} Library;
+
+Library* New_Library();
+void Delete_Library( Library** this );
+
+Song_id     Library_add_song( Library* this, int duration, char name[], char artist[] );
+Song_id     Library_find_song( Library* this, char name[], char artist[] );
+const Song* Library_song( Library* this, Song_id id );
+size_t      Library_delete_song( Library* this, Song_id id );
+
+List_id Library_new_playlist( Library* this );
+List_id Library_copy_playlist( Library* this, List_id list );
+void    Library_delete_playlist( Library* this, List_id list );
+
+void    Library_append( Library* this, List_id list, Song_id id );
+void    Library_remove_at( Library* this, List_id list, size_t index );
+size_t  Library_playlist_len( Library* this, List_id list );
+Song_id Library_playlist_get( Library* this, List_id list, size_t index );
+
+size_t Library_playlists_with( Library* this, Song_id id, List_id out[], size_t max );
+
+List_id   Library_import( Library* this, Playlist* source );
+Playlist* Library_materialize( Library* this, List_id list );
+
+#endif
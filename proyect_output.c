@@ -0,0 +1,299 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <unistd.h>
+#include "proyect_output.h"
+
+/**
+* @brief Prepara un buffer de salida.
+*
+* @param this El buffer.
+* @param fd Descriptor al que se escribe por bloques de OUTPUT_CHUNK; -1 para juntar todo en memoria.
+*/
+void Output_buffer_init( Output_buffer* this, int fd )
+{
+	assert( this );
+	this->cap = OUTPUT_CHUNK;
+	this->data = (char*) malloc( this->cap );
+	assert( this->data );
+	this->len = 0;
+	this->fd = fd;
+	this->failed = false;
+}
+
+/**
+* @brief Libera la memoria del buffer. No escribe lo pendiente: para eso est Output_flush.
+*
+* @param this El buffer.
+*/
+void Output_buffer_free( Output_buffer* this )
+{
+	assert( this );
+	free( this->data );
+	this->data = NULL;
+	this->len = this->cap = 0;
+}
+
+/**
+* @brief Escribe al descriptor todo lo que hay en el buffer, con un solo write si se puede.
+*
+* @param this El buffer.
+*
+* @return false si algn write fall. Sin descriptor no hace nada y devuelve true.
+*/
+bool Output_flush( Output_buffer* this )
+{
+	assert( this );
+	if( this->fd < 0 )
+	{
+		return true;
+	}
+	
+	size_t done = 0;
+	while( done < this->len && !this->failed )
+	{
+		ssize_t n = write( this->fd, this->data + done, this->len - done );
+		if( n < 0 )
+		{
+			if( errno == EINTR ) continue;
+			this->failed = true;
+		}
+		else
+		{
+			done += (size_t) n;
+		}
+	}
+	this->len = 0;
+	return !this->failed;
+}
+
+/**
+* @brief Agrega bytes al buffer; con descriptor, escribe cuando se junta un bloque.
+*
+* @param this El buffer.
+* @param data Los bytes.
+* @param len Cuntos bytes.
+*/
+void Output_put( Output_buffer* this, const char* data, size_t len )
+{
+	if( this->len + len > this->cap )
+	{
+		if( this->fd >= 0 )
+		{
+			Output_flush( this );
+		}
+		if( this->len + len > this->cap )
+		{
+			while( this->len + len > this->cap )
+			{
+				this->cap *= 2;
+			}
+			this->data = (char*) realloc( this->data, this->cap );
+			assert( this->data );
+		}
+	}
+	memcpy( this->data + this->len, data, len );
+	this->len += len;
+}
+
+void Output_put_str( Output_buffer* this, const char* str )
+{
+	Output_put( this, str, strlen( str ) );
+}
+
+/**
+* @brief Agrega un entero en decimal, sin pasar por printf.
+*/
+void Output_put_int( Output_buffer* this, long value )
+{
+	char digits[ 24 ];
+	size_t i = sizeof( digits );
+	unsigned long v = value < 0 ? 0ul - (unsigned long) value : (unsigned long) value;
+	
+	do
+	{
+		digits[ --i ] = (char) ( '0' + v % 10 );
+		v /= 10;
+	} while( v > 0 );
+	if( value < 0 )
+	{
+		digits[ --i ] = '-';
+	}
+	Output_put( this, digits + i, sizeof( digits ) - i );
+}
+
+/**
+* @brief Agrega una duracin en segundos como minutos:segundos, igual que "%d:%02d".
+*/
+void Output_put_mmss( Output_buffer* this, int seconds )
+{
+	Output_put_int( this, seconds / 60 );
+	int s = seconds % 60;
+	if( s < 0 ) // printf no rellena con ceros si ya hay signo: -30 da "0:-30" y -5 da "0:-5"
+	{
+		Output_put( this, ":", 1 );
+		Output_put_int( this, s );
+		return;
+	}
+	char tail[ 3 ] = { ':', (char) ( '0' + s / 10 ), (char) ( '0' + s % 10 ) };
+	Output_put( this, tail, 3 );
+}
+
+/* ---------- Texto ---------- */
+
+static void Text_begin( Output_buffer* out, Playlist* playlist )
+{
+	if( playlist->len == 0 )
+	{
+		Output_put_str( out, "La playlist est vaca\n" );
+	}
+}
+
+static void Text_song( Output_buffer* out, const Song* song, size_t index )
+{
+	(void) index;
+	Output_put_str( out, "Duracin: " );
+	Output_put_mmss( out, song->duration );
+	Output_put_str( out, "\t Nombre: " );
+	Output_put_str( out, song->name );
+	Output_put_str( out, "\t\t Artista: " );
+	Output_put_str( out, song->artist );
+	Output_put( out, "\t\n", 2 );
+}
+
+static void Nothing( Output_buffer* out, Playlist* playlist )
+{
+	(void) out;
+	(void) playlist;
+}
+
+const Output_format OUTPUT_TEXT = { Text_begin, Text_song, Nothing };
+
+/* ---------- JSON ---------- */
+
+/**
+* @brief Agrega una cadena JSON. Los bytes no ASCII se toman como Latin-1, la codificacin
+* de este proyecto, y se escriben como \u00XX para que el resultado sea JSON vlido.
+*/
+static void Json_string( Output_buffer* out, const char* str )
+{
+	static const char hex[] = "0123456789abcdef";
+	
+	Output_put( out, "\"", 1 );
+	const char* run = str; // tramo que se copia tal cual
+	for( ; *str; ++str )
+	{
+		unsigned char c = (unsigned char) *str;
+		if( c >= 0x20 && c < 0x80 && c != '"' && c != '\\' )
+		{
+			continue;
+		}
+		Output_put( out, run, (size_t) ( str - run ) );
+		run = str + 1;
+		
+		if( c == '"' || c == '\\' )
+		{
+			char esc[ 2 ] = { '\\', (char) c };
+			Output_put( out, esc, 2 );
+		}
+		else
+		{
+			char esc[ 6 ] = { '\\', 'u', '0', '0', hex[ c >> 4 ], hex[ c & 0xf ] };
+			Output_put( out, esc, 6 );
+		}
+	}
+	Output_put( out, run, (size_t) ( str - run ) );
+	Output_put( out, "\"", 1 );
+}
+
+static void Json_begin( Output_buffer* out, Playlist* playlist )
+{
+	(void) playlist;
+	Output_put( out, "[", 1 );
+}
+
+static void Json_song( Output_buffer* out, const Song* song, size_t index )
+{
+	Output_put_str( out, index > 0 ? ",\n{\"duration\":" : "\n{\"duration\":" );
+	Output_put_int( out, song->duration );
+	Output_put_str( out, ",\"name\":" );
+	Json_string( out, song->name );
+	Output_put_str( out, ",\"artist\":" );
+	Json_string( out, song->artist );
+	Output_put( out, "}", 1 );
+}
+
+static void Json_end( Output_buffer* out, Playlist* playlist )
+{
+	Output_put_str( out, playlist->len > 0 ? "\n]\n" : "]\n" );
+}
+
+const Output_format OUTPUT_JSON = { Json_begin, Json_song, Json_end };
+
+/* ---------- CSV ---------- */
+
+/**
+* @brief Agrega un campo CSV, entre comillas slo si hace falta (RFC 4180).
+*/
+static void Csv_field( Output_buffer* out, const char* str )
+{
+	if( strpbrk( str, ",\"\r\n" ) == NULL )
+	{
+		Output_put_str( out, str );
+		return;
+	}
+	
+	Output_put( out, "\"", 1 );
+	for( const char* quote; ( quote = strchr( str, '"' ) ) != NULL; str = quote + 1 )
+	{
+		Output_put( out, str, (size_t) ( quote - str ) + 1 );
+		Output_put( out, "\"", 1 ); // comilla doble
+	}
+	Output_put_str( out, str );
+	Output_put( out, "\"", 1 );
+}
+
+static void Csv_begin( Output_buffer* out, Playlist* playlist )
+{
+	(void) playlist;
+	Output_put_str( out, "duration,name,artist\n" );
+}
+
+static void Csv_song( Output_buffer* out, const Song* song, size_t index )
+{
+	(void) index;
+	Output_put_int( out, song->duration );
+	Output_put( out, ",", 1 );
+	Csv_field( out, song->name );
+	Output_put( out, ",", 1 );
+	Csv_field( out, song->artist );
+	Output_put( out, "\n", 1 );
+}
+
+const Output_format OUTPUT_CSV = { Csv_begin, Csv_song, Nothing };
+
+/**
+* @brief Escribe una Playlist completa en el formato dado, sin mover el cursor.
+*
+* @param this Una Playlist.
+* @param format OUTPUT_TEXT, OUTPUT_JSON, OUTPUT_CSV o un formato propio.
+* @param out Buffer de salida; si tiene descriptor, al final se escribe lo pendiente.
+*
+* @return false si fall algn write.
+*/
+bool Playlist_write( Playlist* this, const Output_format* format, Output_buffer* out )
+{
+	assert( this );
+	assert( format );
+	assert( out );
+	
+	format->begin( out, this );
+	size_t i = 0;
+	for( Node* it = this->first; it != NULL; it = it->next )
+	{
+		format->song( out, it->song, i++ );
+	}
+	format->end( out, this );
+	
+	return Output_flush( out );
+}
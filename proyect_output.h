@@ -0,0 +1,39 @@
+#ifndef PROYECT_OUTPUT_H
+#define PROYECT_OUTPUT_H
+
+#include "proyect_playlist.h"
+
+#define OUTPUT_CHUNK 65536 // Con descriptor, se hace un write cada vez que se juntan estos bytes
+
+typedef struct
+{
+	char* data;
+	size_t len;
+	size_t cap;
+	int fd;            // -1: el buffer slo crece y el llamador usa data/len
+	bool failed;       // Fall algn write
+} Output_buffer;
+
+typedef struct
+{
+	void (*begin)( Output_buffer* out, Playlist* playlist );
+	void (*song)( Output_buffer* out, const Song* song, size_t index );
+	void (*end)( Output_buffer* out, Playlist* playlist );
+} Output_format;
+
+extern const Output_format OUTPUT_TEXT; // Mismo formato que Print_Playlist
+extern const Output_format OUTPUT_JSON;
+extern const Output_format OUTPUT_CSV;
+
+void Output_buffer_init( Output_buffer* this, int fd );
+void Output_buffer_free( Output_buffer* this );
+bool Output_flush( Output_buffer* this );
+
+void Output_put( Output_buffer* this, const char* data, size_t len );
+void Output_put_str( Output_buffer* this, const char* str );
+void Output_put_int( Output_buffer* this, long value );
+void Output_put_mmss( Output_buffer* this, int seconds );
+
+bool Playlist_write( Playlist* this, const Output_format* format, Output_buffer* out );
+
+#endif
@@ -0,0 +1,578 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include "proyect_player.h"
+
+/*
+ * Un solo hilo atiende todos los canales. Cada canal tiene un timer en una rueda de
+ * PLAYER_WHEEL_SLOTS casillas de PLAYER_TICK_US: el hilo busca la siguiente casilla ocupada
+ * (con el mapa de bits used), duerme hasta el instante exacto del timer ms prximo y lo
+ * dispara. El fin de una cancin y el inicio de la siguiente son el mismo evento, y el
+ * siguiente fin se calcula a partir del instante programado, no del real, as que el retraso
+ * de un despertar no se acumula.
+ */
+
+#define WHEEL_MASK ( PLAYER_WHEEL_SLOTS - 1 )
+
+static uint32_t Clock_random( Player_clock* clock )
+{
+	uint32_t x = clock->rng;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return clock->rng = x;
+}
+
+static uint64_t Clock_now( Player_clock* clock )
+{
+	if( clock->simulated )
+	{
+		return clock->now_us;
+	}
+	struct timespec ts;
+	clock_gettime( CLOCK_MONOTONIC, &ts );
+	return (uint64_t) ts.tv_sec * 1000000u + (uint64_t) ts.tv_nsec / 1000u;
+}
+
+/**
+* @brief Prepara un reloj simulado: esperar no tarda nada, slo avanza el tiempo.
+*
+* Al despertar para un timer se suma un retraso aleatorio en [0, latency_us], para medir
+* cmo se comporta el planificador con un sistema que no despierta a tiempo.
+*
+* @param clock El reloj a preparar.
+* @param start_us Tiempo inicial.
+* @param latency_us Retraso mximo al despertar; 0 para un reloj perfecto.
+* @param seed Semilla del retraso.
+*/
+void Player_clock_simulated( Player_clock* clock, uint64_t start_us, uint64_t latency_us, uint32_t seed )
+{
+	assert( clock );
+	clock->simulated = true;
+	clock->now_us = start_us;
+	clock->latency_us = latency_us;
+	clock->rng = seed != 0 ? seed : 0x9e3779b9u;
+}
+
+static void Timer_add( Player* this, Player_timer* t )
+{
+	t->tick = t->fire_at / PLAYER_TICK_US;
+	if( t->tick < this->tick )
+	{
+		t->tick = this->tick; // ya venci: se atiende en el tick actual
+	}
+	size_t slot = t->tick & WHEEL_MASK;
+	t->next = this->wheel[ slot ];
+	this->wheel[ slot ] = t;
+	this->used[ slot / 64 ] |= (uint64_t) 1 << ( slot % 64 );
+	++this->timers;
+}
+
+static void Timer_remove( Player* this, Player_timer* t )
+{
+	size_t slot = t->tick & WHEEL_MASK;
+	Player_timer** it = &this->wheel[ slot ];
+	while( *it != t )
+	{
+		assert( *it != NULL );
+		it = &( *it )->next;
+	}
+	*it = t->next;
+	if( this->wheel[ slot ] == NULL )
+	{
+		this->used[ slot / 64 ] &= ~( (uint64_t) 1 << ( slot % 64 ) );
+	}
+	--this->timers;
+}
+
+/**
+* @brief Busca el timer que vence primero.
+*
+* @return El timer, o NULL si no hay ninguno.
+*/
+static Player_timer* Timer_next( Player* this )
+{
+	if( this->timers == 0 )
+	{
+		return NULL;
+	}
+	
+	// Una vuelta a la rueda saltando casillas vacas de 64 en 64
+	for( size_t d = 0; d < PLAYER_WHEEL_SLOTS; )
+	{
+		size_t slot = ( this->tick + d ) & WHEEL_MASK;
+		uint64_t word = this->used[ slot / 64 ] >> ( slot % 64 );
+		if( word == 0 )
+		{
+			d += 64 - slot % 64;
+			continue;
+		}
+		d += (size_t) __builtin_ctzll( word );
+		if( d >= PLAYER_WHEEL_SLOTS )
+		{
+			break;
+		}
+		
+		uint64_t tick = this->tick + d;
+		Player_timer* best = NULL;
+		for( Player_timer* t = this->wheel[ tick & WHEEL_MASK ]; t != NULL; t = t->next )
+		{
+			if( t->tick == tick && ( best == NULL || t->fire_at < best->fire_at ) )
+			{
+				best = t;
+			}
+		}
+		if( best != NULL )
+		{
+			return best;
+		}
+		++d;
+	}
+	
+	// Todos vencen despus de una vuelta completa: se busca el menor directamente
+	Player_timer* best = NULL;
+	for( size_t slot = 0; slot < PLAYER_WHEEL_SLOTS; ++slot )
+	{
+		for( Player_timer* t = this->wheel[ slot ]; t != NULL; t = t->next )
+		{
+			if( best == NULL || t->fire_at < best->fire_at )
+			{
+				best = t;
+			}
+		}
+	}
+	return best;
+}
+
+/**
+* @brief Busca el nodo de una posicin, recorriendo desde el extremo ms cercano.
+*/
+static Node* Node_at( Playlist* playlist, size_t index )
+{
+	Node* it;
+	if( index < playlist->len / 2 )
+	{
+		it = playlist->first;
+		for( size_t i = 0; i < index; ++i )
+		{
+			it = it->next;
+		}
+	}
+	else
+	{
+		it = playlist->last;
+		for( size_t i = playlist->len - 1; i > index; --i )
+		{
+			it = it->prev;
+		}
+	}
+	return it;
+}
+
+/**
+* @brief Copia al buffer del canal las siguientes canciones de su Playlist, hasta lookahead.
+*
+* El canal recuerda la posicin, no el nodo: si la Playlist se edit (entre Player_lock y
+* Player_unlock) el nodo se vuelve a buscar, as que nunca se sigue un nodo ya borrado.
+*/
+static void Prefetch( Player* this, Player_channel* ch )
+{
+	while( ch->count < this->lookahead && ch->next_index < ch->playlist->len )
+	{
+		if( ch->next_node == NULL )
+		{
+			ch->next_node = Node_at( ch->playlist, ch->next_index );
+		}
+		ch->ahead[ ( ch->head + ch->count ) % this->lookahead ] = *ch->next_node->song;
+		++ch->count;
+		++ch->next_index;
+		ch->next_node = ch->next_node->next;
+	}
+}
+
+static void Emit( Player* this, int channel, Player_event_kind kind, const Song* song, int64_t jitter )
+{
+	uint64_t abs_jitter = (uint64_t) ( jitter < 0 ? -jitter : jitter );
+	++this->events;
+	this->jitter_sum += abs_jitter;
+	if( (int64_t) abs_jitter > this->jitter_max )
+	{
+		this->jitter_max = (int64_t) abs_jitter;
+	}
+	if( this->on_event != NULL )
+	{
+		this->on_event( this->ctx, channel, kind, song, jitter );
+	}
+}
+
+/**
+* @brief Atiende el timer de un canal: termina la cancin actual y empieza la siguiente.
+*/
+static void Fire( Player* this, Player_timer* t )
+{
+	int64_t jitter = (int64_t) ( Clock_now( &this->clock ) - t->fire_at );
+	Player_channel* ch = this->channels[ t->channel ];
+	
+	Timer_remove( this, t );
+	this->tick = t->tick;
+	
+	if( ch->playing )
+	{
+		Emit( this, t->channel, PLAYER_SONG_END, &ch->ahead[ ch->head ], jitter );
+		ch->head = ( ch->head + 1 ) % this->lookahead;
+		--ch->count;
+		ch->playing = false;
+	}
+	
+	Prefetch( this, ch );
+	if( ch->count > 0 )
+	{
+		const Song* s = &ch->ahead[ ch->head ];
+		ch->playing = true;
+		Emit( this, t->channel, PLAYER_SONG_START, s, jitter );
+		
+		t->fire_at += (uint64_t) ( s->duration > 0 ? s->duration : 0 ) * 1000000u;
+		Timer_add( this, t );
+	}
+	else
+	{
+		ch->active = false;
+		Emit( this, t->channel, PLAYER_CHANNEL_END, NULL, jitter );
+	}
+}
+
+/**
+* @brief Ciclo del planificador. Se llama con el candado tomado.
+*
+* @param until_us Si no es UINT64_MAX, regresa en cuanto el reloj llega a ese tiempo.
+*/
+static void Run( Player* this, uint64_t until_us )
+{
+	while( !this->stop )
+	{
+		Player_timer* t = Timer_next( this );
+		uint64_t now = Clock_now( &this->clock );
+		
+		if( t != NULL && t->fire_at <= now )
+		{
+			Fire( this, t );
+			continue;
+		}
+		
+		uint64_t deadline = t != NULL ? t->fire_at : UINT64_MAX;
+		bool for_timer = true;
+		if( until_us != UINT64_MAX )
+		{
+			if( now >= until_us )
+			{
+				return;
+			}
+			if( deadline > until_us )
+			{
+				deadline = until_us;
+				for_timer = false;
+			}
+		}
+		
+		if( this->clock.simulated )
+		{
+			if( deadline == UINT64_MAX )
+			{
+				return; // nada que esperar: el tiempo simulado no avanza solo
+			}
+			uint64_t latency = 0;
+			if( for_timer && this->clock.latency_us > 0 )
+			{
+				latency = Clock_random( &this->clock ) % ( this->clock.latency_us + 1 );
+			}
+			this->clock.now_us = deadline + latency;
+		}
+		else if( deadline == UINT64_MAX )
+		{
+			pthread_cond_wait( &this->wake, &this->lock );
+		}
+		else
+		{
+			struct timespec ts;
+			ts.tv_sec = (time_t) ( deadline / 1000000u );
+			ts.tv_nsec = (long) ( deadline % 1000000u ) * 1000;
+			pthread_cond_timedwait( &this->wake, &this->lock, &ts );
+		}
+	}
+}
+
+static void* Player_thread( void* arg )
+{
+	Player* this = (Player*) arg;
+	pthread_mutex_lock( &this->lock );
+	Run( this, UINT64_MAX );
+	pthread_mutex_unlock( &this->lock );
+	return NULL;
+}
+
+/**
+* @brief Crea un planificador de reproduccin.
+*
+* Los eventos se avisan con el candado del planificador tomado: on_event no debe llamar
+* a funciones Player_* ni modificar las Playlist de los canales.
+*
+* @param clock Reloj a usar (se copia); NULL para el reloj monotnico real.
+* @param lookahead Cuntas canciones se precargan por canal, contando la que suena.
+* @param on_event Funcin que recibe los eventos; puede ser NULL.
+* @param ctx Dato del usuario que se le pasa a on_event.
+*
+* @return Una referencia al nuevo planificador.
+*/
+Player* New_Player( const Player_clock* clock, size_t lookahead, Player_event on_event, void* ctx )
+{
+	Player* p = (Player*) calloc( 1, sizeof( Player ) );
+	if( p )
+	{
+		if( clock != NULL )
+		{
+			p->clock = *clock;
+		}
+		p->lookahead = lookahead > 0 ? lookahead : 1;
+		p->on_event = on_event;
+		p->ctx = ctx;
+		p->tick = Clock_now( &p->clock ) / PLAYER_TICK_US;
+		
+		pthread_condattr_t attr;
+		pthread_condattr_init( &attr );
+		pthread_condattr_setclock( &attr, CLOCK_MONOTONIC );
+		pthread_cond_init( &p->wake, &attr );
+		pthread_condattr_destroy( &attr );
+		pthread_mutex_init( &p->lock, NULL );
+	}
+	return p;
+}
+
+/**
+* @brief Detiene y destruye un planificador. Las Playlist de los canales no se tocan.
+*
+* @param this Un planificador.
+*/
+void Delete_Player( Player** this )
+{
+	assert( *this );
+	Player* p = *this;
+	
+	Player_stop( p );
+	for( size_t i = 0; i < p->channels_len; ++i )
+	{
+		free( p->channels[ i ]->ahead );
+		free( p->channels[ i ] );
+	}
+	free( p->channels );
+	pthread_cond_destroy( &p->wake );
+	pthread_mutex_destroy( &p->lock );
+	free( p );
+	
+	*this = NULL;
+}
+
+/**
+* @brief Agrega un canal que reproduce una Playlist desde su cursor (o desde el inicio si
+* el cursor est en NULL). La primera cancin empieza en este momento.
+*
+* Mientras el canal est activo, la Playlist slo puede modificarse entre Player_lock y
+* Player_unlock. Las canciones ya precargadas son copias y suenan igual; el resto sigue
+* desde la misma posicin de la Playlist editada.
+*
+* @param this Un planificador.
+* @param playlist La Playlist a reproducir.
+*
+* @return El nmero de canal.
+*/
+int Player_add_channel( Player* this, Playlist* playlist )
+{
+	assert( this );
+	assert( playlist );
+	pthread_mutex_lock( &this->lock );
+	
+	size_t i = 0;
+	while( i < this->channels_len && this->channels[ i ]->active )
+	{
+		++i;
+	}
+	if( i == this->channels_len )
+	{
+		if( this->channels_len == this->channels_cap )
+		{
+			this->channels_cap = this->channels_cap ? this->channels_cap * 2 : 8;
+			this->channels = (Player_channel**) realloc( this->channels, this->channels_cap * sizeof( Player_channel* ) );
+			assert( this->channels );
+		}
+		Player_channel* ch = (Player_channel*) calloc( 1, sizeof( Player_channel ) );
+		assert( ch );
+		ch->ahead = (Song*) malloc( this->lookahead * sizeof( Song ) );
+		assert( ch->ahead );
+		this->channels[ this->channels_len++ ] = ch;
+	}
+	
+	Player_channel* ch = this->channels[ i ];
+	ch->active = true;
+	ch->playing = false;
+	ch->playlist = playlist;
+	ch->next_index = 0;
+	if( playlist->cursor != NULL )
+	{
+		for( Node* it = playlist->first; it != playlist->cursor; it = it->next )
+		{
+			++ch->next_index;
+		}
+	}
+	ch->next_node = NULL;
+	ch->head = ch->count = 0;
+	Prefetch( this, ch );
+	
+	ch->timer.channel = (int) i;
+	ch->timer.fire_at = Clock_now( &this->clock );
+	Timer_add( this, &ch->timer );
+	
+	pthread_cond_signal( &this->wake );
+	pthread_mutex_unlock( &this->lock );
+	return (int) i;
+}
+
+/**
+* @brief Detiene un canal sin avisar eventos; su nmero puede reutilizarse.
+*
+* @param this Un planificador.
+* @param channel Un nmero de canal.
+*/
+void Player_remove_channel( Player* this, int channel )
+{
+	assert( this );
+	pthread_mutex_lock( &this->lock );
+	assert( channel >= 0 && (size_t) channel < this->channels_len );
+	
+	Player_channel* ch = this->channels[ channel ];
+	if( ch->active )
+	{
+		Timer_remove( this, &ch->timer );
+		ch->active = false;
+	}
+	pthread_mutex_unlock( &this->lock );
+}
+
+/**
+* @brief Toma el candado del planificador para poder modificar las Playlist de los canales.
+*
+* Mientras se tiene, ningn canal lee su Playlist ni se avisan eventos. No se debe llamar
+* a otras funciones Player_* antes de Player_unlock.
+*
+* @param this Un planificador.
+*/
+void Player_lock( Player* this )
+{
+	assert( this );
+	pthread_mutex_lock( &this->lock );
+}
+
+/**
+* @brief Suelta el candado de Player_lock. Los canales olvidan el nodo que tenan guardado
+* y lo vuelven a buscar por su posicin, porque pudo haberse borrado.
+*
+* @param this Un planificador.
+*/
+void Player_unlock( Player* this )
+{
+	assert( this );
+	for( size_t i = 0; i < this->channels_len; ++i )
+	{
+		this->channels[ i ]->next_node = NULL;
+	}
+	pthread_mutex_unlock( &this->lock );
+}
+
+/**
+* @brief Arranca el hilo del planificador.
+*
+* @param this Un planificador con el reloj real.
+*
+* @return false si ya estaba corriendo o no se pudo crear el hilo.
+*/
+bool Player_start( Player* this )
+{
+	assert( this );
+	assert( !this->clock.simulated );
+	
+	if( this->running )
+	{
+		return false;
+	}
+	this->stop = false;
+	this->running = pthread_create( &this->thread, NULL, Player_thread, this ) == 0;
+	return this->running;
+}
+
+/**
+* @brief Detiene el hilo del planificador y espera a que termine.
+*
+* @param this Un planificador.
+*/
+void Player_stop( Player* this )
+{
+	assert( this );
+	if( !this->running )
+	{
+		return;
+	}
+	
+	pthread_mutex_lock( &this->lock );
+	this->stop = true;
+	pthread_cond_signal( &this->wake );
+	pthread_mutex_unlock( &this->lock );
+	
+	pthread_join( this->thread, NULL );
+	this->running = false;
+	this->stop = false;
+}
+
+/**
+* @brief Ejecuta el planificador en el hilo que llama hasta que el reloj llegue a until_us.
+*
+* Con el reloj simulado no espera de verdad, as que sirve para medir la precisin de
+* horas de reproduccin en segundos.
+*
+* @param this Un planificador sin hilo propio.
+* @param until_us Tiempo del reloj en el que regresa.
+*/
+void Player_run_until( Player* this, uint64_t until_us )
+{
+	assert( this );
+	assert( !this->running );
+	
+	pthread_mutex_lock( &this->lock );
+	Run( this, until_us );
+	pthread_mutex_unlock( &this->lock );
+}
+
+/**
+* @brief Devuelve el tiempo actual del reloj del planificador, en microsegundos.
+*/
+uint64_t Player_now( Player* this )
+{
+	assert( this );
+	pthread_mutex_lock( &this->lock );
+	uint64_t now = Clock_now( &this->clock );
+	pthread_mutex_unlock( &this->lock );
+	return now;
+}
+
+/**
+* @brief Devuelve cuntos eventos se han disparado y con qu retraso respecto a lo programado.
+*
+* @param this Un planificador.
+* @param out Estadsticas a llenar.
+*/
+void Player_get_stats( Player* this, Player_stats* out )
+{
+	assert( this );
+	assert( out );
+	pthread_mutex_lock( &this->lock );
+	out->events = this->events;
+	out->mean_jitter_us = this->events > 0 ? (double) this->jitter_sum / this->events : 0.0;
+	out->max_jitter_us = this->jitter_max;
+	pthread_mutex_unlock( &this->lock );
+}
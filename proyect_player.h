@@ -0,0 +1,98 @@
+#ifndef PROYECT_PLAYER_H
+#define PROYECT_PLAYER_H
+
+#include <pthread.h>
+#include "proyect_playlist.h"
+
+#define PLAYER_TICK_US 100000    // Resolucin de cada casilla de la rueda de timers
+#define PLAYER_WHEEL_SLOTS 4096  // Potencia de 2; una vuelta son ~6.8 minutos
+
+typedef enum
+{
+	PLAYER_SONG_START,
+	PLAYER_SONG_END,
+	PLAYER_CHANNEL_END           // La Playlist del canal se termin
+} Player_event_kind;
+
+typedef void (*Player_event)( void* ctx, int channel, Player_event_kind kind, const Song* song, int64_t jitter_us );
+
+typedef struct
+{
+	bool simulated;              // false: CLOCK_MONOTONIC real
+	uint64_t now_us;             // Reloj simulado: tiempo actual
+	uint64_t latency_us;         // Reloj simulado: retraso mximo (aleatorio) al despertar
+	uint32_t rng;
+} Player_clock;
+
+typedef struct Player_timer
+{
+	uint64_t fire_at;            // Microsegundos del reloj
+	uint64_t tick;               // fire_at / PLAYER_TICK_US
+	int channel;
+	struct Player_timer* next;
+} Player_timer;
+
+typedef struct
+{
+	bool active;
+	bool playing;                // Hay una cancin sonando (ahead[ head ])
+	Playlist* playlist;
+	size_t next_index;           // Posicin en la Playlist de la siguiente cancin que falta copiar a ahead
+	Node* next_node;             // Nodo de next_index; NULL si hay que buscarlo (Player_unlock lo invalida)
+	Song* ahead;                 // Canciones precargadas a partir del cursor
+	size_t head;
+	size_t count;
+	Player_timer timer;
+} Player_channel;
+
+typedef struct
+{
+	uint64_t events;
+	double mean_jitter_us;
+	int64_t max_jitter_us;
+} Player_stats;
+
+typedef struct
+{
+	Player_clock clock;
+	size_t lookahead;
+	Player_event on_event;
+	void* ctx;
+	
+	Player_channel** channels;   // Apuntadores: los timers de cada canal estn en la rueda
+	size_t channels_len;
+	size_t channels_cap;
+	
+	Player_timer* wheel[ PLAYER_WHEEL_SLOTS ];
+	uint64_t used[ PLAYER_WHEEL_SLOTS / 64 ]; // Casillas no vacas
+	uint64_t tick;               // ltimo tick procesado
+	size_t timers;
+	
+	uint64_t events;
+	uint64_t jitter_sum;
+	int64_t jitter_max;
+	
+	pthread_mutex_t lock;
+	pthread_cond_t wake;
+	pthread_t thread;
+	bool running;
+	bool stop;
+} Player;
+
+void Player_clock_simulated( Player_clock* clock, uint64_t start_us, uint64_t latency_us, uint32_t seed );
+
+Player* New_Player( const Player_clock* clock, size_t lookahead, Player_event on_event, void* ctx );
+void Delete_Player( Player** this );
+
+int  Player_add_channel( Player* this, Playlist* playlist );
+void Player_remove_channel( Player* this, int channel );
+void Player_lock( Player* this );
+void Player_unlock( Player* this );
+
+bool Player_start( Player* this );
+void Player_stop( Player* this );
+void Player_run_until( Player* this, uint64_t until_us );
+uint64_t Player_now( Player* this );
+void Player_get_stats( Player* this, Player_stats* out );
+
+#endif
@@ -1,4 +1,7 @@
+#include <unistd.h>
 #include "proyect_playlist.h"
+#include "proyect_output.h"
+#include "proyect_hash.h"
 
 /**
 * @brief Crea una nueva cancin ligada a una Playlist.
@@ -43,6 +46,7 @@ Song* New_Song( int duration, char name[], char artist[] )
 		s->duration = duration;
 		strncpy( s->name, name, CHAR_TAM - 1 );
 		strncpy( s->artist, artist, CHAR_TAM - 1 );
+		s->name[ CHAR_TAM - 1 ] = s->artist[ CHAR_TAM - 1 ] = '\0';
 	}
 	return s;
 }
@@ -61,6 +65,378 @@ void Delete_Song( Node* this )
 	this->song = NULL;
 }
 
+/**
+* @brief Compara dos duraciones segn el tipo de montculo.
+*
+* @return true si a debe quedar ms cerca de la raz que b.
+*/
+static bool Int_heap_before( int a, int b, bool is_max )
+{
+	return is_max ? a > b : a < b;
+}
+
+static void Int_heap_push( Int_heap* h, int value, bool is_max )
+{
+	if( h->len == h->cap )
+	{
+		h->cap = h->cap ? h->cap * 2 : 16;
+		h->data = (int*) realloc( h->data, h->cap * sizeof( int ) );
+		assert( h->data );
+	}
+	size_t i = h->len++;
+	h->data[ i ] = value;
+	while( i > 0 && Int_heap_before( h->data[ i ], h->data[ ( i - 1 ) / 2 ], is_max ) )
+	{
+		int tmp = h->data[ i ];
+		h->data[ i ] = h->data[ ( i - 1 ) / 2 ];
+		h->data[ ( i - 1 ) / 2 ] = tmp;
+		i = ( i - 1 ) / 2;
+	}
+}
+
+static void Int_heap_pop( Int_heap* h, bool is_max )
+{
+	assert( h->len > 0 );
+	h->data[ 0 ] = h->data[ --h->len ];
+	size_t i = 0;
+	while( true )
+	{
+		size_t best = i;
+		size_t l = 2 * i + 1;
+		size_t r = l + 1;
+		if( l < h->len && Int_heap_before( h->data[ l ], h->data[ best ], is_max ) ) best = l;
+		if( r < h->len && Int_heap_before( h->data[ r ], h->data[ best ], is_max ) ) best = r;
+		if( best == i )
+		{
+			return;
+		}
+		int tmp = h->data[ i ];
+		h->data[ i ] = h->data[ best ];
+		h->data[ best ] = tmp;
+		i = best;
+	}
+}
+
+static size_t Duration_hash( int duration )
+{
+	return (uint32_t) duration * 2654435761u;
+}
+
+/**
+* @brief Devuelve la casilla de un artista, o la casilla vaca donde ira.
+*/
+static size_t Artist_slot( Playlist_stats* st, const char artist[] )
+{
+	size_t mask = st->artist_cap - 1;
+	size_t i = String_hash( artist ) & mask;
+	while( st->by_artist[ i ].used && strcmp( st->by_artist[ i ].artist, artist ) != 0 )
+	{
+		i = ( i + 1 ) & mask;
+	}
+	return i;
+}
+
+static void Artist_rehash( Playlist_stats* st, size_t cap )
+{
+	Artist_count* old = st->by_artist;
+	size_t old_cap = st->artist_cap;
+	
+	st->artist_cap = cap;
+	st->by_artist = (Artist_count*) calloc( st->artist_cap, sizeof( Artist_count ) );
+	assert( st->by_artist );
+	for( size_t i = 0; i < old_cap; ++i )
+	{
+		if( old[ i ].used )
+		{
+			st->by_artist[ Artist_slot( st, old[ i ].artist ) ] = old[ i ];
+		}
+	}
+	free( old );
+}
+
+/**
+* @brief Busca la entrada de un artista en las estadsticas; si no existe la crea con cuenta 0.
+*/
+static Artist_count* Stats_artist( Playlist_stats* st, const char artist[] )
+{
+	if( ( st->artist_used + 1 ) * 10 > st->artist_cap * 7 )
+	{
+		Artist_rehash( st, st->artist_cap ? st->artist_cap * 2 : 16 );
+	}
+	
+	size_t i = Artist_slot( st, artist );
+	if( !st->by_artist[ i ].used )
+	{
+		st->by_artist[ i ].used = true;
+		strncpy( st->by_artist[ i ].artist, artist, CHAR_TAM - 1 );
+		++st->artist_used;
+	}
+	return &st->by_artist[ i ];
+}
+
+/**
+* @brief Borra la entrada de la casilla hole (corrimiento hacia atrs) y encoge la tabla si qued muy vaca.
+*/
+static void Artist_erase( Playlist_stats* st, size_t hole )
+{
+	size_t mask = st->artist_cap - 1;
+	for( size_t j = ( hole + 1 ) & mask; st->by_artist[ j ].used; j = ( j + 1 ) & mask )
+	{
+		if( Can_shift( hole, j, String_hash( st->by_artist[ j ].artist ) & mask ) )
+		{
+			st->by_artist[ hole ] = st->by_artist[ j ];
+			hole = j;
+		}
+	}
+	memset( &st->by_artist[ hole ], 0, sizeof( Artist_count ) );
+	--st->artist_used;
+	
+	if( st->artist_cap > 16 && st->artist_used * 8 < st->artist_cap )
+	{
+		Artist_rehash( st, st->artist_cap / 2 );
+	}
+}
+
+/**
+* @brief Devuelve la casilla de una duracin, o la casilla vaca donde ira.
+*/
+static size_t Duration_slot( Playlist_stats* st, int duration )
+{
+	size_t mask = st->duration_cap - 1;
+	size_t i = Duration_hash( duration ) & mask;
+	while( st->by_duration[ i ].used && st->by_duration[ i ].duration != duration )
+	{
+		i = ( i + 1 ) & mask;
+	}
+	return i;
+}
+
+static void Duration_rehash( Playlist_stats* st, size_t cap )
+{
+	Duration_count* old = st->by_duration;
+	size_t old_cap = st->duration_cap;
+	
+	st->duration_cap = cap;
+	st->by_duration = (Duration_count*) calloc( st->duration_cap, sizeof( Duration_count ) );
+	assert( st->by_duration );
+	for( size_t i = 0; i < old_cap; ++i )
+	{
+		if( old[ i ].used )
+		{
+			st->by_duration[ Duration_slot( st, old[ i ].duration ) ] = old[ i ];
+		}
+	}
+	free( old );
+}
+
+/**
+* @brief Busca la entrada de una duracin en las estadsticas; si no existe la crea con cuenta 0.
+*/
+static Duration_count* Stats_duration( Playlist_stats* st, int duration )
+{
+	if( ( st->duration_used + 1 ) * 10 > st->duration_cap * 7 )
+	{
+		Duration_rehash( st, st->duration_cap ? st->duration_cap * 2 : 16 );
+	}
+	
+	size_t i = Duration_slot( st, duration );
+	if( !st->by_duration[ i ].used )
+	{
+		st->by_duration[ i ].used = true;
+		st->by_duration[ i ].duration = duration;
+		++st->duration_used;
+	}
+	return &st->by_duration[ i ];
+}
+
+/**
+* @brief Borra la entrada de la casilla hole (corrimiento hacia atrs) y encoge la tabla si qued muy vaca.
+*/
+static void Duration_erase( Playlist_stats* st, size_t hole )
+{
+	size_t mask = st->duration_cap - 1;
+	for( size_t j = ( hole + 1 ) & mask; st->by_duration[ j ].used; j = ( j + 1 ) & mask )
+	{
+		if( Can_shift( hole, j, Duration_hash( st->by_duration[ j ].duration ) & mask ) )
+		{
+			st->by_duration[ hole ] = st->by_duration[ j ];
+			hole = j;
+		}
+	}
+	memset( &st->by_duration[ hole ], 0, sizeof( Duration_count ) );
+	--st->duration_used;
+	
+	if( st->duration_cap > 16 && st->duration_used * 8 < st->duration_cap )
+	{
+		Duration_rehash( st, st->duration_cap / 2 );
+	}
+}
+
+/**
+* @brief Dice si alguna cancin de la Playlist tiene esa duracin.
+*/
+static bool Stats_has_duration( Playlist_stats* st, int duration )
+{
+	return st->duration_cap > 0 && st->by_duration[ Duration_slot( st, duration ) ].used;
+}
+
+/**
+* @brief Reconstruye los montculos slo con las duraciones que siguen en la Playlist, si
+* las que ya no estn son ms de la mitad. Amortizado cuesta O(log n) por cambio.
+*/
+static void Stats_trim_heaps( Playlist_stats* st )
+{
+	size_t limit = 2 * st->duration_used + 16;
+	if( st->min_heap.len <= limit && st->max_heap.len <= limit )
+	{
+		return;
+	}
+	
+	free( st->min_heap.data );
+	free( st->max_heap.data );
+	memset( &st->min_heap, 0, sizeof( Int_heap ) );
+	memset( &st->max_heap, 0, sizeof( Int_heap ) );
+	for( size_t i = 0; i < st->duration_cap; ++i )
+	{
+		if( st->by_duration[ i ].used )
+		{
+			Int_heap_push( &st->min_heap, st->by_duration[ i ].duration, false );
+			Int_heap_push( &st->max_heap, st->by_duration[ i ].duration, true );
+		}
+	}
+}
+
+static size_t Stats_bucket( int duration )
+{
+	if( duration < 0 )
+	{
+		return 0;
+	}
+	size_t b = (size_t) duration / STATS_BUCKET_SECONDS;
+	return b < STATS_BUCKETS ? b : STATS_BUCKETS - 1;
+}
+
+/**
+* @brief Registra una cancin nueva en las estadsticas de una Playlist.
+*/
+static void Stats_add( Playlist_stats* st, const Song* s )
+{
+	st->total_duration += s->duration;
+	++st->histogram[ Stats_bucket( s->duration ) ];
+	
+	if( Stats_artist( st, s->artist )->count++ == 0 )
+	{
+		++st->artists;
+	}
+	
+	if( Stats_duration( st, s->duration )->count++ == 0 )
+	{
+		// Puede quedar repetida junto a una copia vieja que an no llega a la raz
+		Int_heap_push( &st->min_heap, s->duration, false );
+		Int_heap_push( &st->max_heap, s->duration, true );
+		Stats_trim_heaps( st );
+	}
+}
+
+/**
+* @brief Quita una cancin de las estadsticas de una Playlist.
+*
+* @post Las races de min_heap y max_heap corresponden a duraciones que siguen en la Playlist,
+* y las tablas slo tienen entradas con cuenta mayor que 0.
+*/
+static void Stats_remove( Playlist_stats* st, const Song* s )
+{
+	st->total_duration -= s->duration;
+	--st->histogram[ Stats_bucket( s->duration ) ];
+	
+	size_t a = Artist_slot( st, s->artist );
+	assert( st->by_artist[ a ].used && st->by_artist[ a ].count > 0 );
+	if( --st->by_artist[ a ].count == 0 )
+	{
+		--st->artists;
+		Artist_erase( st, a );
+	}
+	
+	size_t d = Duration_slot( st, s->duration );
+	assert( st->by_duration[ d ].used && st->by_duration[ d ].count > 0 );
+	if( --st->by_duration[ d ].count == 0 )
+	{
+		Duration_erase( st, d );
+		while( st->min_heap.len > 0 && !Stats_has_duration( st, st->min_heap.data[ 0 ] ) )
+		{
+			Int_heap_pop( &st->min_heap, false );
+		}
+		while( st->max_heap.len > 0 && !Stats_has_duration( st, st->max_heap.data[ 0 ] ) )
+		{
+			Int_heap_pop( &st->max_heap, true );
+		}
+		Stats_trim_heaps( st );
+	}
+}
+
+/**
+* @brief Libera las tablas de las estadsticas y las deja como las de una Playlist vaca.
+*/
+static void Stats_reset( Playlist_stats* st )
+{
+	free( st->by_artist );
+	free( st->by_duration );
+	free( st->min_heap.data );
+	free( st->max_heap.data );
+	memset( st, 0, sizeof( Playlist_stats ) );
+}
+
+/**
+* @brief Avisa al hook de la Playlist, si tiene uno, de una modificacin.
+*/
+static void Notify( Playlist* this, Playlist_op op, size_t index, uint32_t arg, const Song* song )
+{
+	if( this->hook != NULL )
+	{
+		Playlist_change change = { op, index, arg, song };
+		this->hook( this->hook_ctx, &change );
+	}
+}
+
+/**
+* @brief Avisa al hook de una modificacin que afecta a varias posiciones a la vez.
+*/
+static void Notify_batch( Playlist* this, Playlist_op op, const size_t positions[], const Song* const songs[], size_t count )
+{
+	if( this->hook != NULL && count > 0 )
+	{
+		Playlist_change change = { op, count, 0, NULL, positions, songs };
+		this->hook( this->hook_ctx, &change );
+	}
+}
+
+/**
+* @brief Agrega una posicin a un arreglo que crece segn se necesite.
+*/
+static void Push_position( size_t** data, size_t* len, size_t* cap, size_t value )
+{
+	if( *len == *cap )
+	{
+		*cap = *cap ? *cap * 2 : 64;
+		*data = (size_t*) realloc( *data, *cap * sizeof( size_t ) );
+		assert( *data );
+	}
+	( *data )[ ( *len )++ ] = value;
+}
+
+/**
+* @brief Calcula la posicin del cursor. Cuesta O(posicin), por eso slo se usa si hay hook.
+*/
+static size_t Cursor_index( Playlist* this )
+{
+	size_t i = 0;
+	for( Node* it = this->cursor; it != NULL && it->prev != NULL; it = it->prev )
+	{
+		++i;
+	}
+	return i;
+}
+
 /**
 * @brief Crea Playlist basada en una lista doblemente enlazada.
 *
@@ -74,6 +450,9 @@ Playlist* New_Playlist()
 	{
 		list->first = list->last = list->cursor = NULL;
 		list->len = 0;
+		memset( &list->stats, 0, sizeof( Playlist_stats ) );
+		list->hook = NULL;
+		list->hook_ctx = NULL;
 	}
 	return list;
 }
@@ -87,6 +466,7 @@ void Delete_Playlist( Playlist** this )
 {
 	assert( *this );
 	
+	( *this )->hook = NULL; // destruir la Playlist en memoria no es vaciarla
 	Make_Playlist_Empty( *this); // primero borra todos los nodos!
 	
 	free( *this );// luego borra al propio objeto this
@@ -94,6 +474,20 @@ void Delete_Playlist( Playlist** this )
 	*this = NULL; // luego haz que this sea NULL
 }
 
+/**
+* @brief Registra una funcin a la que se le avisa de cada modificacin de la Playlist.
+*
+* @param this Una Playlist.
+* @param hook La funcin; NULL para dejar de avisar.
+* @param ctx Dato del usuario que se le pasa a hook.
+*/
+void Playlist_set_hook( Playlist* this, Playlist_hook hook, void* ctx )
+{
+	assert( this );
+	this->hook = hook;
+	this->hook_ctx = ctx;
+}
+
 /**
 * @brief Inserta una cancin en el principio de la Playlist.
 *
@@ -119,6 +513,8 @@ void Insert_Song_front( Playlist* this, int duration, char name[], char artist[]
 		this->first = this->last = this->cursor = n;
 	}
 	++this->len;
+	Stats_add( &this->stats, n->song );
+	Notify( this, PLAYLIST_OP_INSERT_FRONT, 0, 0, n->song );
 }
 
 /**
@@ -147,6 +543,8 @@ void Insert_Song_back( Playlist* this, int duration, char name[], char artist[]
 		this->first = this->last = this->cursor = n;
 	}
 	++this->len;
+	Stats_add( &this->stats, n->song );
+	Notify( this, PLAYLIST_OP_INSERT_BACK, 0, 0, n->song );
 }
 
 /**
@@ -177,6 +575,11 @@ void Insert_Song( Playlist* this, int duration, char name[], char artist[] )
 		n->prev = this->cursor;
 		this->cursor = n;
 		++this->len;
+		Stats_add( &this->stats, n->song );
+		if( this->hook != NULL )
+		{
+			Notify( this, PLAYLIST_OP_INSERT_AT, Cursor_index( this ), 0, n->song );
+		}
 	}
 }
 
@@ -192,8 +595,11 @@ void Erase_Song_front( Playlist* this )
 	assert( this );
 	assert( this->len > 0 );
 	
+	Notify( this, PLAYLIST_OP_ERASE_FRONT, 0, 0, NULL );
+	
 	if( this->last != this->first ) // tambin funciona: if( this->len > 1 ){...}
 	{
+		Stats_remove( &this->stats, this->first->song );
 		Delete_Song( this->first );
 		Node* tmp = this->first->next;
 		free( this->first );
@@ -203,6 +609,7 @@ void Erase_Song_front( Playlist* this )
 	}
 	else
 	{
+		Stats_remove( &this->stats, this->first->song );
 		Delete_Song( this->first );
 		free( this->first );
 		this->first = this->last = this->cursor = NULL;
@@ -223,8 +630,11 @@ void Erase_Song_back( Playlist* this )
 	assert( this->len > 0 );
 	// ERR: no se puede borrar nada de una lista vaca
 	
+	Notify( this, PLAYLIST_OP_ERASE_BACK, 0, 0, NULL );
+	
 	if( this->last != this->first ) // tambin funciona: if( this->len > 1 ){...}
 	{
+		Stats_remove( &this->stats, this->last->song );
 		Delete_Song( this->last );
 		Node* x = this->last->prev;
 		free( this->last );
@@ -234,6 +644,7 @@ void Erase_Song_back( Playlist* this )
 	}
 	else
 	{
+		Stats_remove( &this->stats, this->last->song );
 		Delete_Song( this->last );
 		free( this->last );
 		this->first = this->last = this->cursor = NULL;
@@ -256,6 +667,8 @@ void Erase_Song( Playlist* this )
 	
 	if ( this->first == this->last )
 	{
+		Notify( this, PLAYLIST_OP_ERASE_AT, 0, 0, NULL );
+		Stats_remove( &this->stats, this->cursor->song );
 		Delete_Song( this->cursor );
 		free( this->cursor );
 		this->first = this->last = this->cursor = NULL;
@@ -273,6 +686,11 @@ void Erase_Song( Playlist* this )
 	}
 	else
 	{
+		if( this->hook != NULL )
+		{
+			Notify( this, PLAYLIST_OP_ERASE_AT, Cursor_index( this ), 0, NULL );
+		}
+		Stats_remove( &this->stats, this->cursor->song );
 		Delete_Song( this->cursor );
 		Node* left = this->cursor->prev;
 		Node* right = this->cursor->next;
@@ -311,6 +729,89 @@ void Remove_Song( Playlist* this, char key[] )
 	this->cursor = tmp;
 }
 
+/**
+* @brief Elimina, en un solo recorrido, todas las canciones que cumplan el predicado.
+*
+* @param this Una Playlist.
+* @param pred Funcin que devuelve true para las canciones a eliminar.
+* @param ctx Dato del usuario que se le pasa a pred en cada llamada.
+*
+* @return El nmero de canciones eliminadas.
+*
+* @post Si el cursor apuntaba a una cancin que sobrevive, no se mueve. Si apuntaba a
+* una cancin eliminada, se coloca en la siguiente sobreviviente a su derecha; si no
+* la hay, en la ltima de la Playlist (NULL si qued vaca). Si estaba en NULL, sigue en NULL.
+*/
+size_t Playlist_remove_if( Playlist* this, Song_predicate pred, void* ctx )
+{
+	assert( this );
+	assert( pred );
+	
+	Node* garbage = NULL; // nodos desligados, se liberan al final
+	bool cursor_removed = false;
+	Node* new_cursor = NULL;
+	size_t removed = 0;
+	size_t pos = 0;
+	size_t* positions = NULL; // slo si hay hook: se avisa con un solo ERASE_SET
+	size_t positions_len = 0;
+	size_t positions_cap = 0;
+	
+	Node* it = this->first;
+	while( it != NULL )
+	{
+		Node* right = it->next;
+		
+		if( pred( it->song, ctx ) )
+		{
+			if( this->hook != NULL )
+			{
+				Push_position( &positions, &positions_len, &positions_cap, pos );
+			}
+			
+			if( it->prev != NULL ) it->prev->next = right;
+			else                   this->first = right;
+			
+			if( right != NULL ) right->prev = it->prev;
+			else                this->last = it->prev;
+			
+			if( it == this->cursor )
+			{
+				cursor_removed = true;
+			}
+			
+			it->next = garbage;
+			garbage = it;
+			++removed;
+		}
+		else if( cursor_removed && new_cursor == NULL )
+		{
+			new_cursor = it;
+		}
+		++pos;
+		it = right;
+	}
+	
+	Notify_batch( this, PLAYLIST_OP_ERASE_SET, positions, NULL, positions_len );
+	free( positions );
+	
+	if( cursor_removed )
+	{
+		this->cursor = new_cursor != NULL ? new_cursor : this->last;
+	}
+	this->len -= removed;
+	
+	while( garbage != NULL )
+	{
+		Node* tmp = garbage->next;
+		Stats_remove( &this->stats, garbage->song );
+		Delete_Song( garbage );
+		free( garbage );
+		garbage = tmp;
+	}
+	
+	return removed;
+}
+
 /**
 * @brief Busca una cancin en la Playlist. Si lo encuentra coloca ah al cursor.
 *
@@ -463,13 +964,74 @@ size_t Playlist_Num_Songs( Playlist* this )
 void Make_Playlist_Empty( Playlist* this )
 {
 	assert( this );
-	if ( Playlist_Num_Songs > 0 )
+	
+	Notify( this, PLAYLIST_OP_CLEAR, 0, 0, NULL );
+	
+	Node* it = this->first;
+	while( it != NULL )
+	{
+		Node* tmp = it->next;
+		Delete_Song( it );
+		free( it );
+		it = tmp;
+	}
+	this->first = this->last = this->cursor = NULL;
+	this->len = 0;
+	Stats_reset( &this->stats ); // no hace falta descontar cancin por cancin
+}
+
+/**
+* @brief Llena un resumen con las estadsticas de una Playlist. Cuesta O(1).
+*
+* Las estadsticas se actualizan en cada insercin y borrado, as que no se recorre la lista.
+*
+* @param this Una Playlist.
+* @param out Resumen a llenar.
+*/
+void Playlist_summary( Playlist* this, Playlist_Summary* out )
+{
+	assert( this );
+	assert( out );
+	
+	const Playlist_stats* st = &this->stats;
+	
+	out->songs = this->len;
+	out->total_duration = st->total_duration;
+	out->average_duration = this->len > 0 ? (double) st->total_duration / this->len : 0.0;
+	out->min_duration = st->min_heap.len > 0 ? st->min_heap.data[ 0 ] : 0;
+	out->max_duration = st->max_heap.len > 0 ? st->max_heap.data[ 0 ] : 0;
+	out->artists = st->artists;
+	memcpy( out->histogram, st->histogram, sizeof( out->histogram ) );
+}
+
+/**
+* @brief Devuelve cuntas canciones de un artista hay en la Playlist. Cuesta O(1) en promedio.
+*
+* @param this Una Playlist.
+* @param artist El nombre del artista.
+*
+* @return El nmero de canciones del artista.
+*/
+size_t Playlist_artist_count( Playlist* this, const char artist[] )
+{
+	assert( this );
+	
+	const Playlist_stats* st = &this->stats;
+	if( st->artist_cap == 0 )
+	{
+		return 0;
+	}
+	
+	size_t i = String_hash( artist ) & ( st->artist_cap - 1 );
+	while( st->by_artist[ i ].used )
 	{
-		while( this->first )
+		if( strcmp( st->by_artist[ i ].artist, artist ) == 0 )
 		{
-			Erase_Song_front( this );
+			return st->by_artist[ i ].count;
 		}
+		i = ( i + 1 ) & ( st->artist_cap - 1 );
 	}
+	return 0;
 }
 
 /**
@@ -497,25 +1059,21 @@ void Print_Current_Song( Playlist* this )
 /**
 * @brief Imprime los datos de toda una Playlist.
 *
+* El texto se escribe con Playlist_write directo a la salida estndar, de a OUTPUT_CHUNK bytes,
+* as que no mueve el cursor y la memoria usada no depende del largo de la Playlist. Antes se
+* vaca stdout para no mezclarse fuera de orden con otros printf.
+*
 * @param this Una Playlist.
 */
 void Print_Playlist( Playlist* this )
 {
 	assert( this );
 	
-	if( Playlist_Num_Songs( this ) == 0 )
-	{
-		printf( "La playlist est vaca\n" );
-	}
-	else
-	{
-		Node* tmp = this->cursor;
-		for( First_Song( this ); !Playlist_end( this ); Next_Song( this ) )
-		{
-			Print_Current_Song( this );
-		}
-		this->cursor = tmp;
-	}
+	fflush( stdout );
+	Output_buffer out;
+	Output_buffer_init( &out, STDOUT_FILENO );
+	Playlist_write( this, &OUTPUT_TEXT, &out );
+	Output_buffer_free( &out );
 }
 
 /**
@@ -648,6 +1206,8 @@ void Playlist_ordered_duration( Playlist* this, size_t elems )
 		return;
 	}
 	
+	Notify( this, PLAYLIST_OP_SORT, elems, SONG_KEY_DURATION, NULL );
+	
 	this->cursor = this->last;
 	int i = 0;
 	while ( i < elems ) 
@@ -693,6 +1253,8 @@ void Playlist_ordered_name( Playlist* this, size_t elems )
 	{
 		return;
 	}
+	
+	Notify( this, PLAYLIST_OP_SORT, elems, SONG_KEY_NAME, NULL );
 	this->cursor = this->last;
 	int i = 0;
 	while (i < elems) 
@@ -738,6 +1300,8 @@ void Playlist_ordered_artist( Playlist* this, size_t elems )
 	{
 		return;
 	}
+	
+	Notify( this, PLAYLIST_OP_SORT, elems, SONG_KEY_ARTIST, NULL );
 	this->cursor = this->last;
 	int i = 0;
 	while (i < elems) 
@@ -786,3 +1350,833 @@ void Copy_Playlist( Playlist* this, Playlist* other )
 	}
 	this->cursor = temp;
 }
+
+/**
+* @brief Compara dos canciones segn la llave de ordenamiento dada.
+*
+* @param a Una cancin.
+* @param b Otra cancin.
+* @param key Llave de ordenamiento.
+*
+* @return Negativo si a va antes que b; positivo si va despus; 0 si son equivalentes.
+*/
+static int Compare_Songs( const Song* a, const Song* b, Song_key key )
+{
+	switch( key )
+	{
+		case SONG_KEY_DURATION: return ( b->duration > a->duration ) - ( b->duration < a->duration );
+		case SONG_KEY_NAME:     return strcmp( a->name, b->name );
+		case SONG_KEY_ARTIST:   return strcmp( a->artist, b->artist );
+	}
+	return 0;
+}
+
+/**
+* @brief Conjunto de canciones con direccionamiento abierto, indexado por nombre+artista.
+*/
+typedef struct
+{
+	const Song** slots;
+	size_t mask;
+} Song_set;
+
+static bool Song_same_key( const Song* a, const Song* b )
+{
+	return strcmp( a->name, b->name ) == 0 && strcmp( a->artist, b->artist ) == 0;
+}
+
+/**
+* @brief Inicializa un conjunto con espacio para al menos elems canciones.
+*/
+static void Song_set_init( Song_set* set, size_t elems )
+{
+	size_t cap = 16;
+	while( cap < elems * 2 )
+	{
+		cap <<= 1;
+	}
+	set->slots = (const Song**) calloc( cap, sizeof( const Song* ) );
+	assert( set->slots );
+	set->mask = cap - 1;
+}
+
+static void Song_set_free( Song_set* set )
+{
+	free( set->slots );
+	set->slots = NULL;
+}
+
+/**
+* @brief Busca la casilla de la cancin en el conjunto.
+*
+* @return La casilla que la contiene o la casilla vaca donde ira.
+*/
+static const Song** Song_set_slot( Song_set* set, const Song* s )
+{
+	size_t i = Key_hash( s->name, s->artist ) & set->mask;
+	while( set->slots[ i ] != NULL && !Song_same_key( set->slots[ i ], s ) )
+	{
+		i = ( i + 1 ) & set->mask;
+	}
+	return &set->slots[ i ];
+}
+
+static bool Song_set_contains( Song_set* set, const Song* s )
+{
+	return *Song_set_slot( set, s ) != NULL;
+}
+
+/**
+* @brief Inserta una cancin en el conjunto.
+*
+* @return true si se insert; false si ya estaba.
+*/
+static bool Song_set_insert( Song_set* set, const Song* s )
+{
+	const Song** slot = Song_set_slot( set, s );
+	if( *slot != NULL )
+	{
+		return false;
+	}
+	*slot = s;
+	return true;
+}
+
+/**
+* @brief Agrega a dest las canciones de src (sin duplicados) segn su pertenencia a filter.
+*
+* @param dest Playlist destino.
+* @param src Playlist de donde se toman las canciones.
+* @param seen Canciones ya agregadas a dest.
+* @param filter Conjunto contra el que se prueba cada cancin; NULL para no filtrar.
+* @param member Si es true se agregan las que estn en filter; si es false, las que no.
+*/
+static void Append_unique( Playlist* dest, Playlist* src, Song_set* seen, Song_set* filter, bool member )
+{
+	for( Node* it = src->first; it != NULL; it = it->next )
+	{
+		if( filter != NULL && Song_set_contains( filter, it->song ) != member )
+		{
+			continue;
+		}
+		if( Song_set_insert( seen, it->song ) )
+		{
+			Insert_Song_back( dest, it->song->duration, it->song->name, it->song->artist );
+		}
+	}
+}
+
+/**
+* @brief Crea la unin de dos Playlist: las canciones de this y luego las de other, sin repetidos.
+*
+* Dos canciones son la misma si coinciden en nombre y artista; se conserva la primera aparicin.
+*
+* @param this Una Playlist.
+* @param other Otra Playlist.
+*
+* @return Una referencia a la nueva Playlist.
+*/
+Playlist* Playlist_union( Playlist* this, Playlist* other )
+{
+	assert( this );
+	assert( other );
+	
+	Playlist* result = New_Playlist();
+	assert( result );
+	
+	Song_set seen;
+	Song_set_init( &seen, this->len + other->len );
+	Append_unique( result, this, &seen, NULL, true );
+	Append_unique( result, other, &seen, NULL, true );
+	Song_set_free( &seen );
+	
+	return result;
+}
+
+/**
+* @brief Crea la interseccin de dos Playlist: las canciones de this que tambin estn en other.
+*
+* @param this Una Playlist.
+* @param other Otra Playlist.
+*
+* @return Una referencia a la nueva Playlist, en el orden de this y sin repetidos.
+*/
+Playlist* Playlist_intersection( Playlist* this, Playlist* other )
+{
+	assert( this );
+	assert( other );
+	
+	Playlist* result = New_Playlist();
+	assert( result );
+	
+	Song_set in_other;
+	Song_set_init( &in_other, other->len );
+	for( Node* it = other->first; it != NULL; it = it->next )
+	{
+		Song_set_insert( &in_other, it->song );
+	}
+	
+	Song_set seen;
+	Song_set_init( &seen, this->len );
+	Append_unique( result, this, &seen, &in_other, true );
+	
+	Song_set_free( &seen );
+	Song_set_free( &in_other );
+	return result;
+}
+
+/**
+* @brief Crea la diferencia de dos Playlist: las canciones de this que no estn en other.
+*
+* @param this Una Playlist.
+* @param other Otra Playlist.
+*
+* @return Una referencia a la nueva Playlist, en el orden de this y sin repetidos.
+*/
+Playlist* Playlist_difference( Playlist* this, Playlist* other )
+{
+	assert( this );
+	assert( other );
+	
+	Playlist* result = New_Playlist();
+	assert( result );
+	
+	Song_set in_other;
+	Song_set_init( &in_other, other->len );
+	for( Node* it = other->first; it != NULL; it = it->next )
+	{
+		Song_set_insert( &in_other, it->song );
+	}
+	
+	Song_set seen;
+	Song_set_init( &seen, this->len );
+	Append_unique( result, this, &seen, &in_other, false );
+	
+	Song_set_free( &seen );
+	Song_set_free( &in_other );
+	return result;
+}
+
+/**
+* @brief Mezcla dos Playlist ya ordenadas por la misma llave, moviendo los nodos de other a this.
+*
+* No copia canciones: reenlaza los nodos. Ante empates van primero los de this.
+*
+* @param this Playlist ordenada que recibe las canciones.
+* @param other Playlist ordenada que se vaca.
+* @param key La llave con la que ambas estn ordenadas.
+*
+* @post this queda ordenada con len = this->len + other->len y su cursor no se mueve
+* (si this estaba vaca apunta a la primera cancin); other queda vaca.
+*/
+void Playlist_merge( Playlist* this, Playlist* other, Song_key key )
+{
+	assert( this );
+	assert( other );
+	assert( this != other );
+	
+	for( Node* it = other->first; it != NULL; it = it->next )
+	{
+		Stats_add( &this->stats, it->song );
+	}
+	Stats_reset( &other->stats );
+	Notify( other, PLAYLIST_OP_CLEAR, 0, 0, NULL );
+	
+	size_t* positions = NULL; // slo si hay hook: se avisa con un solo MERGE
+	const Song** songs = NULL;
+	size_t merged = 0;
+	if( this->hook != NULL && other->len > 0 )
+	{
+		positions = (size_t*) malloc( other->len * sizeof( size_t ) );
+		songs = (const Song**) malloc( other->len * sizeof( const Song* ) );
+		assert( positions && songs );
+	}
+	
+	size_t index = 0;
+	Node* a = this->first;
+	Node* b = other->first;
+	Node* head = NULL;
+	Node* tail = NULL;
+	
+	while( a != NULL || b != NULL )
+	{
+		Node* n;
+		if( b == NULL || ( a != NULL && Compare_Songs( a->song, b->song, key ) <= 0 ) )
+		{
+			n = a;
+			a = a->next;
+		}
+		else
+		{
+			n = b;
+			b = b->next;
+			if( positions != NULL )
+			{
+				positions[ merged ] = index;
+				songs[ merged++ ] = n->song;
+			}
+		}
+		++index;
+		
+		n->prev = tail;
+		n->next = NULL;
+		if( tail != NULL ) tail->next = n;
+		else               head = n;
+		tail = n;
+	}
+	
+	Notify_batch( this, PLAYLIST_OP_MERGE, positions, songs, merged );
+	free( positions );
+	free( songs );
+	
+	bool was_empty = ( this->first == NULL );
+	this->first = head;
+	this->last = tail;
+	this->len += other->len;
+	if( was_empty )
+	{
+		this->cursor = this->first;
+	}
+	
+	other->first = other->last = other->cursor = NULL;
+	other->len = 0;
+}
+
+/**
+* @brief Hunde la raz de un montculo cuya raz es la cancin que va al ltimo segn key.
+*/
+static void Heap_sift_down( const Song* heap[], size_t len, size_t i, Song_key key )
+{
+	while( true )
+	{
+		size_t worst = i;
+		size_t l = 2 * i + 1;
+		size_t r = l + 1;
+		if( l < len && Compare_Songs( heap[ l ], heap[ worst ], key ) > 0 ) worst = l;
+		if( r < len && Compare_Songs( heap[ r ], heap[ worst ], key ) > 0 ) worst = r;
+		if( worst == i )
+		{
+			return;
+		}
+		const Song* tmp = heap[ i ];
+		heap[ i ] = heap[ worst ];
+		heap[ worst ] = tmp;
+		i = worst;
+	}
+}
+
+/**
+* @brief Obtiene las primeras k canciones segn la llave dada, sin ordenar ni copiar la Playlist.
+*
+* Usa out como un montculo acotado de k elementos: O(n log k) y sin memoria extra.
+*
+* @param this Una Playlist.
+* @param key Llave de ordenamiento (el mismo orden que Playlist_ordered_*).
+* @param k Cuntas canciones se quieren.
+* @param out Arreglo de al menos k elementos donde se dejan las canciones, ya ordenadas.
+*
+* @return El nmero de canciones escritas en out: el menor entre k y el tamao de la Playlist.
+* @post Ni la Playlist ni su cursor se modifican; las canciones de out pertenecen a this.
+*/
+size_t Playlist_top_k( Playlist* this, Song_key key, size_t k, const Song* out[] )
+{
+	assert( this );
+	assert( out != NULL || k == 0 );
+	
+	size_t len = 0;
+	for( Node* it = this->first; it != NULL && k > 0; it = it->next )
+	{
+		if( len < k )
+		{
+			// sube el nuevo elemento mientras vaya despus que su padre
+			size_t i = len++;
+			out[ i ] = it->song;
+			while( i > 0 && Compare_Songs( out[ i ], out[ ( i - 1 ) / 2 ], key ) > 0 )
+			{
+				const Song* tmp = out[ i ];
+				out[ i ] = out[ ( i - 1 ) / 2 ];
+				out[ ( i - 1 ) / 2 ] = tmp;
+				i = ( i - 1 ) / 2;
+			}
+		}
+		else if( Compare_Songs( it->song, out[ 0 ], key ) < 0 )
+		{
+			out[ 0 ] = it->song;
+			Heap_sift_down( out, len, 0, key );
+		}
+	}
+	
+	// heapsort: la peor queda al final en cada paso
+	for( size_t n = len; n > 1; --n )
+	{
+		const Song* tmp = out[ 0 ];
+		out[ 0 ] = out[ n - 1 ];
+		out[ n - 1 ] = tmp;
+		Heap_sift_down( out, n - 1, 0, key );
+	}
+	return len;
+}
+
+/**
+* @brief Generador xorshift32: reproducible a partir de su semilla, sin tocar rand().
+*
+* @param state Estado del generador; nunca debe ser 0.
+*
+* @return El siguiente nmero pseudoaleatorio.
+*/
+static uint32_t Xorshift32( uint32_t* state )
+{
+	uint32_t x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return *state = x;
+}
+
+/**
+* @brief Devuelve un nmero pseudoaleatorio en [0, n).
+*/
+static size_t Random_below( uint32_t* state, size_t n )
+{
+	return (size_t) ( ( (uint64_t) Xorshift32( state ) * n ) >> 32 );
+}
+
+/**
+* @brief Crea una etapa de vista sin configurar.
+*/
+static Playlist_view* New_View_stage( View_kind kind, Playlist_view* parent )
+{
+	Playlist_view* v = (Playlist_view*) calloc( 1, sizeof( Playlist_view ) );
+	assert( v );
+	v->kind = kind;
+	v->parent = parent;
+	return v;
+}
+
+/**
+* @brief Crea una vista sobre una Playlist. No copia canciones.
+*
+* @param source La Playlist que se va a recorrer.
+*
+* @return Una referencia a la nueva vista.
+* @post Mientras se recorra la vista, source no debe modificarse.
+*/
+Playlist_view* New_Playlist_view( Playlist* source )
+{
+	assert( source );
+	Playlist_view* v = New_View_stage( VIEW_SOURCE, NULL );
+	v->source = source;
+	return v;
+}
+
+/**
+* @brief Agrega a una vista una etapa que slo deja pasar las canciones que cumplen pred.
+*
+* @param parent Vista de entrada; la nueva etapa se vuelve su duea.
+* @param pred Predicado que deben cumplir las canciones.
+* @param ctx Dato del usuario que se le pasa a pred.
+*
+* @return Una referencia a la nueva vista.
+*/
+Playlist_view* Playlist_view_filter( Playlist_view* parent, Song_predicate pred, void* ctx )
+{
+	assert( parent );
+	assert( pred );
+	Playlist_view* v = New_View_stage( VIEW_FILTER, parent );
+	v->pred = pred;
+	v->ctx = ctx;
+	return v;
+}
+
+/**
+* @brief Agrega a una vista una etapa de tiempo limitado, con el mismo criterio que Playlist_limited.
+*
+* @param parent Vista de entrada; la nueva etapa se vuelve su duea.
+* @param max_duration Lo mximo que puede durar la vista, en segundos.
+*
+* @return Una referencia a la nueva vista.
+*/
+Playlist_view* Playlist_view_limit( Playlist_view* parent, int max_duration )
+{
+	assert( parent );
+	Playlist_view* v = New_View_stage( VIEW_LIMIT, parent );
+	v->max_duration = max_duration;
+	return v;
+}
+
+/**
+* @brief Agrega a una vista una etapa que se salta offset canciones y deja pasar a lo ms count.
+*
+* @param parent Vista de entrada; la nueva etapa se vuelve su duea.
+* @param offset Canciones a saltar.
+* @param count Mximo de canciones a dejar pasar.
+*
+* @return Una referencia a la nueva vista.
+*/
+Playlist_view* Playlist_view_slice( Playlist_view* parent, size_t offset, size_t count )
+{
+	assert( parent );
+	Playlist_view* v = New_View_stage( VIEW_SLICE, parent );
+	v->offset = offset;
+	v->count = count;
+	return v;
+}
+
+/**
+* @brief Agrega a una vista una etapa que entrega las canciones en orden aleatorio.
+*
+* Guarda slo apuntadores a las canciones y las baraja conforme se van pidiendo
+* (Fisher-Yates incremental), as que tomar las primeras k cuesta O(n + k).
+*
+* @param parent Vista de entrada; la nueva etapa se vuelve su duea.
+* @param seed Semilla; la misma semilla da la misma permutacin.
+*
+* @return Una referencia a la nueva vista.
+*/
+Playlist_view* Playlist_view_shuffle( Playlist_view* parent, uint32_t seed )
+{
+	assert( parent );
+	Playlist_view* v = New_View_stage( VIEW_SHUFFLE, parent );
+	v->seed = seed != 0 ? seed : 0x9e3779b9u;
+	return v;
+}
+
+/**
+* @brief Destruye una vista junto con todas sus etapas anteriores. No toca la Playlist fuente.
+*
+* @param this Una vista.
+*/
+void Delete_Playlist_view( Playlist_view** this )
+{
+	assert( *this );
+	
+	Playlist_view* v = *this;
+	while( v != NULL )
+	{
+		Playlist_view* parent = v->parent;
+		free( v->pool );
+		free( v );
+		v = parent;
+	}
+	*this = NULL;
+}
+
+/**
+* @brief Reinicia el estado de recorrido de una etapa y de las anteriores.
+*/
+static void View_rewind( Playlist_view* v )
+{
+	if( v->parent != NULL )
+	{
+		View_rewind( v->parent );
+	}
+	v->started = false;
+	v->current = NULL;
+	v->it = NULL;
+	v->elapsed = 0;
+	v->index = 0;
+	v->pool_len = 0;
+	v->rng = v->seed;
+}
+
+/**
+* @brief Obtiene la siguiente cancin que entrega una etapa.
+*
+* @return La cancin, o NULL si la etapa ya termin.
+*/
+static const Song* View_pull( Playlist_view* v )
+{
+	switch( v->kind )
+	{
+		case VIEW_SOURCE:
+		{
+			if( !v->started )
+			{
+				v->it = v->source->first;
+				v->started = true;
+			}
+			else if( v->it != NULL )
+			{
+				v->it = v->it->next;
+			}
+			return v->it ? v->it->song : NULL;
+		}
+		
+		case VIEW_FILTER:
+		{
+			const Song* s;
+			do
+			{
+				s = View_pull( v->parent );
+			} while( s != NULL && !v->pred( s, v->ctx ) );
+			return s;
+		}
+		
+		case VIEW_LIMIT:
+		{
+			if( v->elapsed < 0 )
+			{
+				return NULL;
+			}
+			const Song* s = View_pull( v->parent );
+			if( s == NULL || v->elapsed + s->duration > v->max_duration )
+			{
+				v->elapsed = -1; // como Playlist_limited: la primera que no cabe termina la vista
+				return NULL;
+			}
+			v->elapsed += s->duration;
+			return s;
+		}
+		
+		case VIEW_SLICE:
+		{
+			for( ; v->index < v->offset; ++v->index )
+			{
+				if( View_pull( v->parent ) == NULL )
+				{
+					return NULL;
+				}
+			}
+			if( v->index - v->offset >= v->count )
+			{
+				return NULL;
+			}
+			++v->index;
+			return View_pull( v->parent );
+		}
+		
+		case VIEW_SHUFFLE:
+		{
+			if( !v->started )
+			{
+				const Song* s;
+				while( ( s = View_pull( v->parent ) ) != NULL )
+				{
+					if( v->pool_len == v->pool_cap )
+					{
+						v->pool_cap = v->pool_cap ? v->pool_cap * 2 : 64;
+						v->pool = (const Song**) realloc( v->pool, v->pool_cap * sizeof( const Song* ) );
+						assert( v->pool );
+					}
+					v->pool[ v->pool_len++ ] = s;
+				}
+				v->started = true;
+			}
+			if( v->index >= v->pool_len )
+			{
+				return NULL;
+			}
+			size_t j = v->index + Random_below( &v->rng, v->pool_len - v->index );
+			const Song* tmp = v->pool[ v->index ];
+			v->pool[ v->index ] = v->pool[ j ];
+			v->pool[ j ] = tmp;
+			return v->pool[ v->index++ ];
+		}
+	}
+	return NULL;
+}
+
+/**
+* @brief Coloca a la vista en su primera cancin, evaluando las etapas desde cero.
+*
+* @param this Una vista.
+*/
+void Playlist_view_first( Playlist_view* this )
+{
+	assert( this );
+	View_rewind( this );
+	this->current = View_pull( this );
+}
+
+/**
+* @brief Avanza la vista a su siguiente cancin.
+*
+* @param this Una vista.
+*/
+void Playlist_view_next( Playlist_view* this )
+{
+	assert( this );
+	assert( this->current != NULL );
+	this->current = View_pull( this );
+}
+
+/**
+* @brief Indica si la vista termin su recorrido.
+*
+* @param this Una vista.
+*
+* @return true si ya no hay canciones; false en caso contrario.
+*/
+bool Playlist_view_end( Playlist_view* this )
+{
+	return this->current == NULL;
+}
+
+/**
+* @brief Devuelve la cancin actual de la vista, sin copiarla.
+*
+* @param this Una vista.
+*
+* @return La cancin actual; pertenece a la Playlist fuente.
+*/
+const Song* Playlist_view_song( Playlist_view* this )
+{
+	assert( this->current != NULL );
+	return this->current;
+}
+
+/**
+* @brief Crea una Playlist con las canciones que entrega la vista.
+*
+* @param this Una vista.
+*
+* @return Una referencia a la nueva Playlist.
+*/
+Playlist* Playlist_view_materialize( Playlist_view* this )
+{
+	assert( this );
+	
+	Playlist* result = New_Playlist();
+	assert( result );
+	
+	for( Playlist_view_first( this ); !Playlist_view_end( this ); Playlist_view_next( this ) )
+	{
+		const Song* s = Playlist_view_song( this );
+		Insert_Song_back( result, s->duration, (char*) s->name, (char*) s->artist );
+	}
+	return result;
+}
+
+typedef struct
+{
+	double pos;
+	size_t index;   // Desempate: qsort no es estable y el orden no debe depender de la libc
+	Node* node;
+} Spread_slot;
+
+static int Compare_Slots_index( const Spread_slot* a, const Spread_slot* b )
+{
+	return ( a->index > b->index ) - ( a->index < b->index );
+}
+
+static int Compare_Slots_artist( const void* a, const void* b )
+{
+	const Spread_slot* sa = (const Spread_slot*) a;
+	const Spread_slot* sb = (const Spread_slot*) b;
+	int c = strcmp( sa->node->song->artist, sb->node->song->artist );
+	return c != 0 ? c : Compare_Slots_index( sa, sb );
+}
+
+static int Compare_Slots_pos( const void* a, const void* b )
+{
+	const Spread_slot* sa = (const Spread_slot*) a;
+	const Spread_slot* sb = (const Spread_slot*) b;
+	int c = ( sa->pos > sb->pos ) - ( sa->pos < sb->pos );
+	return c != 0 ? c : Compare_Slots_index( sa, sb );
+}
+
+/**
+* @brief Devuelve un nmero pseudoaleatorio en [0, 1).
+*/
+static double Random_unit( uint32_t* state )
+{
+	return ( Xorshift32( state ) >> 8 ) * ( 1.0 / 16777216.0 );
+}
+
+/**
+* @brief Baraja una Playlist en su lugar separando lo ms posible las canciones del mismo artista.
+*
+* Las c canciones de cada artista se barajan entre s y se reparten en posiciones
+* (i + desfase) / c de [0, 1), con un desfase aleatorio por artista y un pequeo ruido
+* por cancin; luego se ordena todo por posicin. Cuesta O(n log n) y reenlaza los
+* nodos sin copiar canciones.
+*
+* @param this Una Playlist.
+* @param seed Semilla; la misma semilla da el mismo orden.
+*
+* @post El cursor queda en la primera cancin.
+*/
+void Playlist_shuffle_spread( Playlist* this, uint32_t seed )
+{
+	assert( this );
+	
+	Notify( this, PLAYLIST_OP_SHUFFLE, 0, seed, NULL );
+	
+	size_t n = this->len;
+	if( n < 2 )
+	{
+		this->cursor = this->first;
+		return;
+	}
+	
+	Spread_slot* slots = (Spread_slot*) malloc( n * sizeof( Spread_slot ) );
+	assert( slots );
+	
+	size_t i = 0;
+	for( Node* it = this->first; it != NULL; it = it->next, ++i )
+	{
+		slots[ i ].index = i;
+		slots[ i ].node = it;
+	}
+	qsort( slots, n, sizeof( Spread_slot ), Compare_Slots_artist ); // agrupa por artista, en el orden original
+	
+	uint32_t rng = seed != 0 ? seed : 0x9e3779b9u;
+	for( size_t begin = 0; begin < n; )
+	{
+		size_t end = begin + 1;
+		while( end < n && strcmp( slots[ end ].node->song->artist, slots[ begin ].node->song->artist ) == 0 )
+		{
+			++end;
+		}
+		size_t count = end - begin;
+		
+		for( size_t j = count; j > 1; --j ) // Fisher-Yates dentro del artista
+		{
+			size_t k = Random_below( &rng, j );
+			Node* tmp = slots[ begin + j - 1 ].node;
+			slots[ begin + j - 1 ].node = slots[ begin + k ].node;
+			slots[ begin + k ].node = tmp;
+		}
+		
+		double offset = Random_unit( &rng );
+		for( size_t j = 0; j < count; ++j )
+		{
+			double jitter = ( Random_unit( &rng ) - 0.5 ) * 0.2; // +-10% del espacio entre canciones
+			slots[ begin + j ].pos = ( j + offset + jitter ) / count;
+			slots[ begin + j ].index = begin + j;
+		}
+		begin = end;
+	}
+	qsort( slots, n, sizeof( Spread_slot ), Compare_Slots_pos );
+	
+	for( i = 0; i < n; ++i )
+	{
+		Node* node = slots[ i ].node;
+		node->prev = i > 0 ? slots[ i - 1 ].node : NULL;
+		node->next = i + 1 < n ? slots[ i + 1 ].node : NULL;
+	}
+	this->first = this->cursor = slots[ 0 ].node;
+	this->last = slots[ n - 1 ].node;
+	
+	free( slots );
+}
+
+/**
+* @brief Crea una Playlist con las canciones de otra, barajadas separando a los artistas.
+*
+* @param this Una Playlist.
+* @param seed Semilla; la misma semilla da el mismo orden.
+*
+* @return Una referencia a la nueva Playlist.
+*/
+Playlist* Playlist_random_spread( Playlist* this, uint32_t seed )
+{
+	assert( this );
+	
+	Playlist* spread = New_Playlist();
+	assert( spread );
+	
+	Copy_Playlist( this, spread );
+	Playlist_shuffle_spread( spread, seed );
+	return spread;
+}
@@ -1,11 +1,17 @@
+#ifndef PROYECT_PLAYLIST_H
+#define PROYECT_PLAYLIST_H
+
 #include <stdlib.h>
 #include <stdio.h>
 #include <stdbool.h>
 #include <assert.h>
 #include <string.h>
 #include <time.h>
+#include <stdint.h>
 
 #define CHAR_TAM 30
+#define STATS_BUCKETS 10        // Cubetas del histograma de duraciones
+#define STATS_BUCKET_SECONDS 60 // Ancho de cada cubeta; la ltima junta todo lo que sobra
 
 typedef struct
 {
@@ -22,19 +28,142 @@ typedef struct Node
 	struct Node* prev;
 } Node;
 
+typedef struct
+{
+	char artist [CHAR_TAM];
+	size_t count;
+	bool used;
+} Artist_count;
+
+typedef struct
+{
+	int duration;
+	size_t count;
+	bool used;
+} Duration_count;
+
+typedef struct
+{
+	int* data;
+	size_t len;
+	size_t cap;
+} Int_heap;
+
+typedef struct
+{
+	long total_duration;
+	size_t artists;                  // Artistas distintos con al menos una cancin
+	size_t histogram[ STATS_BUCKETS ];
+	
+	Artist_count* by_artist;         // Tablas hash con direccionamiento abierto; slo cuentas > 0
+	size_t artist_cap;
+	size_t artist_used;
+	Duration_count* by_duration;
+	size_t duration_cap;
+	size_t duration_used;
+	
+	Int_heap min_heap;               // Duraciones distintas; las que ya no estn se sacan al llegar a la
+	Int_heap max_heap;               // raz, y si se acumulan muchas el montculo se reconstruye
+} Playlist_stats;
+
+typedef enum
+{
+	PLAYLIST_OP_INSERT_FRONT,
+	PLAYLIST_OP_INSERT_BACK,
+	PLAYLIST_OP_INSERT_AT,   // La cancin queda en la posicin index
+	PLAYLIST_OP_ERASE_FRONT,
+	PLAYLIST_OP_ERASE_BACK,
+	PLAYLIST_OP_ERASE_AT,    // Se borra la cancin de la posicin index
+	PLAYLIST_OP_SORT,        // Playlist_ordered_* con key = arg y elems = index
+	PLAYLIST_OP_SHUFFLE,     // Playlist_shuffle_spread con seed = arg
+	PLAYLIST_OP_CLEAR,
+	PLAYLIST_OP_ERASE_SET,   // Se borran las index canciones de las posiciones positions
+	PLAYLIST_OP_MERGE        // Las index canciones songs quedan en las posiciones positions
+} Playlist_op;
+
+typedef struct
+{
+	Playlist_op op;
+	size_t index;
+	uint32_t arg;
+	const Song* song;        // Slo en las inserciones
+	const size_t* positions; // ERASE_SET y MERGE: posiciones en orden creciente
+	const Song* const* songs;// MERGE: la cancin de cada posicin
+} Playlist_change;
+
+typedef void (*Playlist_hook)( void* ctx, const Playlist_change* change );
+
 typedef struct
 {
 	Node* first;
 	Node* last;
 	Node* cursor;
 	size_t len;
+	Playlist_stats stats;
+	Playlist_hook hook;      // Se llama en cada modificacin; NULL si nadie escucha
+	void* hook_ctx;
 } Playlist;
 
+typedef struct
+{
+	size_t songs;
+	long   total_duration;
+	double average_duration;
+	int    min_duration;             // 0 si la Playlist est vaca
+	int    max_duration;
+	size_t artists;
+	size_t histogram[ STATS_BUCKETS ];
+} Playlist_Summary;
+
+typedef enum
+{
+	SONG_KEY_DURATION, // De mayor a menor duracin, como Playlist_ordered_duration
+	SONG_KEY_NAME,     // Alfabtico por nombre, como Playlist_ordered_name
+	SONG_KEY_ARTIST    // Alfabtico por artista, como Playlist_ordered_artist
+} Song_key;
+
+typedef bool (*Song_predicate)( const Song* song, void* ctx );
+
+typedef enum
+{
+	VIEW_SOURCE,
+	VIEW_FILTER,
+	VIEW_LIMIT,
+	VIEW_SLICE,
+	VIEW_SHUFFLE
+} View_kind;
+
+typedef struct Playlist_view
+{
+	View_kind kind;
+	struct Playlist_view* parent; // Etapa anterior; NULL en VIEW_SOURCE
+	Playlist* source;             // Slo en VIEW_SOURCE
+	
+	Song_predicate pred;          // VIEW_FILTER
+	void* ctx;
+	int max_duration;             // VIEW_LIMIT
+	size_t offset;                // VIEW_SLICE
+	size_t count;
+	uint32_t seed;                // VIEW_SHUFFLE
+	
+	// Estado del recorrido
+	bool started;
+	Node* it;
+	const Song* current;
+	int elapsed;
+	size_t index;
+	const Song** pool;
+	size_t pool_len;
+	size_t pool_cap;
+	uint32_t rng;
+} Playlist_view;
+
 Song* New_Song( int duration, char name[], char artist[] );
 void  Delete_Song( Node* this );
 
 Playlist* New_Playlist();
 void Delete_Playlist( Playlist** this );
+void Playlist_set_hook( Playlist* this, Playlist_hook hook, void* ctx );
 
 void Insert_Song_front( Playlist* this, int duration, char name[], char artist[]  );
 void Insert_Song_back( Playlist* this, int duration, char name[], char artist[] );
@@ -45,6 +174,7 @@ void Erase_Song_back( Playlist* this );
 void Erase_Song( Playlist* this );
 
 void Remove_Song( Playlist* this, char key[] );
+size_t Playlist_remove_if( Playlist* this, Song_predicate pred, void* ctx );
 bool Find_Song( Playlist* this, char key[] );
 
 int    Get_duration( Playlist* this );
@@ -61,6 +191,9 @@ void   Make_Playlist_Empty( Playlist* this );
 bool   Playlist_Is_empty( Playlist* this );
 size_t Playlist_Num_Songs( Playlist* this );
 
+void   Playlist_summary( Playlist* this, Playlist_Summary* out );
+size_t Playlist_artist_count( Playlist* this, const char artist[] );
+
 void Print_Current_Song( Playlist* this );
 void Print_Playlist( Playlist* this );
 
@@ -69,7 +202,30 @@ void Play_Playlist( Playlist* this );
 
 Playlist* Playlist_random( Playlist* this );
 Playlist* Playlist_limited( Playlist* this, int max_duration );
+Playlist* Playlist_random_spread( Playlist* this, uint32_t seed );
+void Playlist_shuffle_spread( Playlist* this, uint32_t seed );
 void Playlist_ordered_duration( Playlist* this, size_t elems );
 void Playlist_ordered_name( Playlist* this, size_t elems );
 void Playlist_ordered_artist( Playlist* this, size_t elems );
 void Copy_Playlist( Playlist* this, Playlist* other );
+
+Playlist* Playlist_union( Playlist* this, Playlist* other );
+Playlist* Playlist_intersection( Playlist* this, Playlist* other );
+Playlist* Playlist_difference( Playlist* this, Playlist* other );
+void Playlist_merge( Playlist* this, Playlist* other, Song_key key );
+size_t Playlist_top_k( Playlist* this, Song_key key, size_t k, const Song* out[] );
+
+Playlist_view* New_Playlist_view( Playlist* source );
+Playlist_view* Playlist_view_filter( Playlist_view* parent, Song_predicate pred, void* ctx );
+Playlist_view* Playlist_view_limit( Playlist_view* parent, int max_duration );
+Playlist_view* Playlist_view_slice( Playlist_view* parent, size_t offset, size_t count );
+Playlist_view* Playlist_view_shuffle( Playlist_view* parent, uint32_t seed );
+void Delete_Playlist_view( Playlist_view** this );
+
+void        Playlist_view_first( Playlist_view* this );
+void        Playlist_view_next( Playlist_view* this );
+bool        Playlist_view_end( Playlist_view* this );
+const Song* Playlist_view_song( Playlist_view* this );
+Playlist*   Playlist_view_materialize( Playlist_view* this );
+
+#endif
@@ -0,0 +1,671 @@
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "proyect_shm.h"
+
+#define SHARED_MAGIC 0x504c534du // "PLSM"
+
+/*
+ * Un solo proceso escribe y cualquier nmero lee. El escritor deja seq impar mientras
+ * modifica el segmento; un lector copia lo que necesita y despus verifica que seq no
+ * haya cambiado (seqlock). Los enlaces son ndices, as que el segmento puede quedar
+ * mapeado en direcciones distintas en cada proceso.
+ *
+ * Adems el escritor tiene el candado del encabezado mientras modifica. Un lector que
+ * no logra leer sin l (el escritor es lento, modifica muy seguido o muri) lo toma:
+ * as siempre avanza, y si el escritor muri a media modificacin el candado robusto
+ * lo avisa en lugar de dejar al lector esperando para siempre.
+ */
+
+/**
+* @brief Toma el candado del encabezado.
+*
+* @return false si el escritor muri a media modificacin: el segmento ya no es consistente.
+*/
+static bool Lock( Shared_Playlist* this )
+{
+	int r = pthread_mutex_lock( &this->header->lock );
+	if( r == EOWNERDEAD )
+	{
+		if( __atomic_load_n( &this->header->seq, __ATOMIC_ACQUIRE ) & 1 )
+		{
+			pthread_mutex_unlock( &this->header->lock ); // sin consistent: queda inservible
+			return false;
+		}
+		pthread_mutex_consistent( &this->header->lock ); // muri un lector; los datos estn bien
+		r = 0;
+	}
+	return r == 0;
+}
+
+static void Unlock( Shared_Playlist* this )
+{
+	pthread_mutex_unlock( &this->header->lock );
+}
+
+static void Write_begin( Shared_Playlist* this )
+{
+	assert( this->writer );
+	bool locked = Lock( this );
+	assert( locked );
+	(void) locked;
+	__atomic_store_n( &this->header->seq, this->header->seq + 1, __ATOMIC_RELAXED );
+	__atomic_thread_fence( __ATOMIC_RELEASE );
+}
+
+static void Write_end( Shared_Playlist* this )
+{
+	__atomic_store_n( &this->header->seq, this->header->seq + 1, __ATOMIC_RELEASE );
+	Unlock( this );
+}
+
+/**
+* @brief Empieza una lectura: espera a que el escritor no est a media modificacin.
+*
+* Cede el CPU a lo ms SHARED_SPIN_MAX veces; despus espera en el candado del escritor.
+*
+* @param this Una Playlist compartida.
+* @param version Donde se deja la versin con la que se lee; se le pasa a Shared_read_retry.
+*
+* @return false si el escritor muri a media modificacin.
+*/
+bool Shared_read_begin( Shared_Playlist* this, uint64_t* version )
+{
+	assert( this );
+	assert( version );
+	for( int i = 0; i < SHARED_SPIN_MAX; ++i )
+	{
+		*version = __atomic_load_n( &this->header->seq, __ATOMIC_ACQUIRE );
+		if( ( *version & 1 ) == 0 )
+		{
+			return true;
+		}
+		sched_yield();
+	}
+	
+	if( !Lock( this ) )
+	{
+		return false;
+	}
+	*version = __atomic_load_n( &this->header->seq, __ATOMIC_ACQUIRE ); // par: el escritor no est
+	Unlock( this );
+	return true;
+}
+
+/**
+* @brief Termina una lectura.
+*
+* @param this Una Playlist compartida.
+* @param version Lo que dej Shared_read_begin.
+*
+* @return true si el escritor modific algo y lo ledo se debe descartar.
+*/
+bool Shared_read_retry( Shared_Playlist* this, uint64_t version )
+{
+	assert( this );
+	__atomic_thread_fence( __ATOMIC_ACQUIRE );
+	return __atomic_load_n( &this->header->seq, __ATOMIC_RELAXED ) != version;
+}
+
+static size_t Header_len()
+{
+	size_t page = (size_t) sysconf( _SC_PAGESIZE );
+	return ( sizeof( Shared_header ) + page - 1 ) / page * page;
+}
+
+static size_t Segment_len( uint32_t capacity )
+{
+	return Header_len() + (size_t) capacity * sizeof( Shared_node );
+}
+
+/**
+* @brief Mapea el segmento: el encabezado con escritura (el candado lo necesita) y las
+* canciones con escritura slo para el escritor.
+*/
+static Shared_Playlist* Map_segment( const char name[], int fd, bool writer, size_t len )
+{
+	size_t header_len = Header_len();
+	if( len < header_len )
+	{
+		return NULL;
+	}
+	void* base = mmap( NULL, header_len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+	if( base == MAP_FAILED )
+	{
+		return NULL;
+	}
+	void* nodes = NULL;
+	if( len > header_len )
+	{
+		nodes = mmap( NULL, len - header_len, writer ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, (off_t) header_len );
+		if( nodes == MAP_FAILED )
+		{
+			munmap( base, header_len );
+			return NULL;
+		}
+	}
+	
+	Shared_Playlist* this = (Shared_Playlist*) malloc( sizeof( Shared_Playlist ) );
+	assert( this );
+	this->name = (char*) malloc( strlen( name ) + 1 );
+	assert( this->name );
+	strcpy( this->name, name );
+	this->fd = fd;
+	this->writer = writer;
+	this->map_len = len;
+	this->header_len = header_len;
+	this->header = (Shared_header*) base;
+	this->nodes = (Shared_node*) nodes;
+	return this;
+}
+
+/**
+* @brief Crea una Playlist en un segmento de memoria compartida POSIX. Quien la crea es el nico escritor.
+*
+* @param name Nombre del segmento para shm_open, p. ej. "/catalogo".
+* @param capacity Nmero mximo de canciones; el segmento no crece.
+*
+* @return Una referencia a la Playlist compartida, o NULL si el segmento ya existe o no se pudo crear.
+*/
+Shared_Playlist* Shared_Playlist_create( const char name[], uint32_t capacity )
+{
+	assert( name );
+	assert( capacity > 0 && capacity < SHARED_NIL );
+	
+	int fd = shm_open( name, O_RDWR | O_CREAT | O_EXCL, 0644 );
+	if( fd < 0 )
+	{
+		return NULL;
+	}
+	
+	size_t len = Segment_len( capacity );
+	Shared_Playlist* this = NULL;
+	if( ftruncate( fd, (off_t) len ) == 0 )
+	{
+		this = Map_segment( name, fd, true, len );
+	}
+	if( this == NULL )
+	{
+		close( fd );
+		shm_unlink( name );
+		return NULL;
+	}
+	
+	Shared_header* h = this->header; // ftruncate ya dej todo en ceros
+	h->capacity = capacity;
+	h->first = h->last = h->free_head = SHARED_NIL;
+	
+	pthread_mutexattr_t attr;
+	pthread_mutexattr_init( &attr );
+	pthread_mutexattr_setpshared( &attr, PTHREAD_PROCESS_SHARED );
+	pthread_mutexattr_setrobust( &attr, PTHREAD_MUTEX_ROBUST );
+	pthread_mutex_init( &h->lock, &attr );
+	pthread_mutexattr_destroy( &attr );
+	__atomic_store_n( &h->magic, SHARED_MAGIC, __ATOMIC_RELEASE );
+	return this;
+}
+
+/**
+* @brief Se conecta como lector a una Playlist compartida existente.
+*
+* El segmento se abre con escritura porque el lector puede tener que tomar el candado del
+* encabezado; las canciones quedan mapeadas de slo lectura.
+*
+* @param name Nombre del segmento.
+*
+* @return Una referencia de lector, o NULL si no existe o no es una Playlist compartida.
+*/
+Shared_Playlist* Shared_Playlist_attach( const char name[] )
+{
+	assert( name );
+	
+	int fd = shm_open( name, O_RDWR, 0 );
+	if( fd < 0 )
+	{
+		return NULL;
+	}
+	
+	struct stat st;
+	Shared_Playlist* this = NULL;
+	if( fstat( fd, &st ) == 0 )
+	{
+		this = Map_segment( name, fd, false, (size_t) st.st_size );
+	}
+	if( this != NULL && ( __atomic_load_n( &this->header->magic, __ATOMIC_ACQUIRE ) != SHARED_MAGIC ||
+	                      Segment_len( this->header->capacity ) != this->map_len ) )
+	{
+		Shared_Playlist_detach( &this );
+		return NULL;
+	}
+	if( this == NULL )
+	{
+		close( fd );
+	}
+	return this;
+}
+
+/**
+* @brief Desmapea el segmento en este proceso. El segmento sigue existiendo para los dems.
+*
+* @param this Una Playlist compartida.
+*/
+void Shared_Playlist_detach( Shared_Playlist** this )
+{
+	assert( *this );
+	
+	if( ( *this )->nodes != NULL )
+	{
+		munmap( ( *this )->nodes, ( *this )->map_len - ( *this )->header_len );
+	}
+	munmap( ( *this )->header, ( *this )->header_len );
+	close( ( *this )->fd );
+	free( ( *this )->name );
+	free( *this );
+	
+	*this = NULL;
+}
+
+/**
+* @brief Borra el nombre del segmento; la memoria se libera cuando todos se desconectan.
+*
+* @param name Nombre del segmento.
+*
+* @return true si se borr.
+*/
+bool Shared_Playlist_unlink( const char name[] )
+{
+	return shm_unlink( name ) == 0;
+}
+
+/**
+* @brief Toma una casilla libre y le copia la cancin.
+*
+* @return El ndice de la casilla, o SHARED_NIL si el segmento est lleno.
+*/
+static uint32_t New_Shared_node( Shared_Playlist* this, int duration, char name[], char artist[] )
+{
+	Shared_header* h = this->header;
+	uint32_t i;
+	if( h->free_head != SHARED_NIL )
+	{
+		i = h->free_head;
+		h->free_head = this->nodes[ i ].next;
+	}
+	else if( h->used < h->capacity )
+	{
+		i = h->used++;
+	}
+	else
+	{
+		return SHARED_NIL;
+	}
+	
+	Song* s = &this->nodes[ i ].song;
+	memset( s, 0, sizeof( Song ) );
+	s->duration = duration;
+	strncpy( s->name, name, CHAR_TAM - 1 );
+	strncpy( s->artist, artist, CHAR_TAM - 1 );
+	this->nodes[ i ].next = this->nodes[ i ].prev = SHARED_NIL;
+	return i;
+}
+
+static void Delete_Shared_node( Shared_Playlist* this, uint32_t i )
+{
+	this->nodes[ i ].next = this->header->free_head;
+	this->header->free_head = i;
+}
+
+/**
+* @brief Inserta una cancin en el principio de la Playlist compartida.
+*
+* @param this Una Playlist compartida abierta como escritor.
+* @param duration La duracin de la cancin a insertar.
+* @param name El nombre de la cancin a insertar.
+* @param artist El nombre del artista de la cancin a insertar.
+*
+* @return false si el segmento est lleno.
+*/
+bool Shared_Insert_Song_front( Shared_Playlist* this, int duration, char name[], char artist[] )
+{
+	assert( this );
+	Shared_header* h = this->header;
+	
+	Write_begin( this );
+	uint32_t n = New_Shared_node( this, duration, name, artist );
+	if( n != SHARED_NIL )
+	{
+		if( h->first != SHARED_NIL )
+		{
+			this->nodes[ n ].next = h->first;
+			this->nodes[ h->first ].prev = n;
+			h->first = n;
+		}
+		else
+		{
+			h->first = h->last = n;
+		}
+		++h->len;
+	}
+	Write_end( this );
+	return n != SHARED_NIL;
+}
+
+/**
+* @brief Inserta una cancin al final de la Playlist compartida.
+*
+* @param this Una Playlist compartida abierta como escritor.
+* @param duration La duracin de la cancin a insertar.
+* @param name El nombre de la cancin a insertar.
+* @param artist El nombre del artista de la cancin a insertar.
+*
+* @return false si el segmento est lleno.
+*/
+bool Shared_Insert_Song_back( Shared_Playlist* this, int duration, char name[], char artist[] )
+{
+	assert( this );
+	Shared_header* h = this->header;
+	
+	Write_begin( this );
+	uint32_t n = New_Shared_node( this, duration, name, artist );
+	if( n != SHARED_NIL )
+	{
+		if( h->last != SHARED_NIL )
+		{
+			this->nodes[ n ].prev = h->last;
+			this->nodes[ h->last ].next = n;
+			h->last = n;
+		}
+		else
+		{
+			h->first = h->last = n;
+		}
+		++h->len;
+	}
+	Write_end( this );
+	return n != SHARED_NIL;
+}
+
+/**
+* @brief Elimina la cancin al principio de la Playlist compartida.
+*
+* @param this Una Playlist compartida abierta como escritor.
+*/
+void Shared_Erase_Song_front( Shared_Playlist* this )
+{
+	assert( this );
+	Shared_header* h = this->header;
+	assert( h->len > 0 );
+	
+	Write_begin( this );
+	uint32_t old = h->first;
+	h->first = this->nodes[ old ].next;
+	if( h->first != SHARED_NIL )
+	{
+		this->nodes[ h->first ].prev = SHARED_NIL;
+	}
+	else
+	{
+		h->last = SHARED_NIL;
+	}
+	Delete_Shared_node( this, old );
+	--h->len;
+	Write_end( this );
+}
+
+/**
+* @brief Elimina la cancin al final de la Playlist compartida.
+*
+* @param this Una Playlist compartida abierta como escritor.
+*/
+void Shared_Erase_Song_back( Shared_Playlist* this )
+{
+	assert( this );
+	Shared_header* h = this->header;
+	assert( h->len > 0 );
+	
+	Write_begin( this );
+	uint32_t old = h->last;
+	h->last = this->nodes[ old ].prev;
+	if( h->last != SHARED_NIL )
+	{
+		this->nodes[ h->last ].next = SHARED_NIL;
+	}
+	else
+	{
+		h->first = SHARED_NIL;
+	}
+	Delete_Shared_node( this, old );
+	--h->len;
+	Write_end( this );
+}
+
+/**
+* @brief Elimina todas las canciones de la Playlist compartida. Cuesta O(1).
+*
+* @param this Una Playlist compartida abierta como escritor.
+*/
+void Shared_Make_Playlist_Empty( Shared_Playlist* this )
+{
+	assert( this );
+	Shared_header* h = this->header;
+	
+	Write_begin( this );
+	h->first = h->last = h->free_head = SHARED_NIL;
+	h->used = 0;
+	h->len = 0;
+	Write_end( this );
+}
+
+/**
+* @brief Reemplaza el contenido de la Playlist compartida por el de una Playlist normal,
+* en una sola modificacin: los lectores ven la anterior completa o la nueva completa.
+*
+* @param this Una Playlist compartida abierta como escritor.
+* @param source La Playlist a publicar.
+*
+* @return false si no cabe; en ese caso la Playlist compartida no cambia.
+*/
+bool Shared_Playlist_load( Shared_Playlist* this, Playlist* source )
+{
+	assert( this );
+	assert( source );
+	Shared_header* h = this->header;
+	
+	if( source->len > h->capacity )
+	{
+		return false;
+	}
+	
+	Write_begin( this );
+	uint32_t i = 0;
+	for( Node* it = source->first; it != NULL; it = it->next, ++i )
+	{
+		Shared_node* n = &this->nodes[ i ];
+		n->song = *it->song;
+		n->prev = i > 0 ? i - 1 : SHARED_NIL;
+		n->next = it->next != NULL ? i + 1 : SHARED_NIL;
+	}
+	h->first = i > 0 ? 0 : SHARED_NIL;
+	h->last = i > 0 ? i - 1 : SHARED_NIL;
+	h->free_head = SHARED_NIL;
+	h->used = i;
+	h->len = i;
+	Write_end( this );
+	return true;
+}
+
+/**
+* @brief Devuelve el nmero de canciones de la Playlist compartida.
+*
+* @param this Una Playlist compartida.
+*
+* @return El nmero de canciones; 0 si el escritor muri a media modificacin.
+*/
+size_t Shared_Playlist_Num_Songs( Shared_Playlist* this )
+{
+	uint64_t v, len;
+	do
+	{
+		if( !Shared_read_begin( this, &v ) )
+		{
+			return 0;
+		}
+		len = this->header->len;
+	} while( Shared_read_retry( this, v ) );
+	return (size_t) len;
+}
+
+/**
+* @brief Coloca un cursor de lectura al inicio de la Playlist compartida.
+*
+* @param this Una Playlist compartida.
+* @param cursor El cursor del lector; cada lector tiene el suyo.
+*
+* @post Si el escritor muri a media modificacin el cursor queda obsoleto.
+*/
+void Shared_First_Song( Shared_Playlist* this, Shared_cursor* cursor )
+{
+	assert( cursor );
+	cursor->stale = false;
+	do
+	{
+		if( !Shared_read_begin( this, &cursor->version ) )
+		{
+			cursor->node = SHARED_NIL;
+			cursor->stale = true;
+			return;
+		}
+		cursor->node = this->header->first;
+	} while( Shared_read_retry( this, cursor->version ) );
+}
+
+/**
+* @brief Copia la cancin del cursor y lo avanza a la siguiente.
+*
+* Si el escritor modific la Playlist desde Shared_First_Song, el recorrido ya no es
+* consistente: se devuelve false con cursor->stale en true y hay que empezar de nuevo.
+* Con un escritor activo, un recorrido largo rara vez termina; para copiar una Playlist
+* grande conviene Shared_Playlist_copy.
+*
+* @param this Una Playlist compartida.
+* @param cursor El cursor del lector.
+* @param out Donde se copia la cancin.
+*
+* @return true si se copi una cancin; false al terminar o si el recorrido qued obsoleto.
+*/
+bool Shared_Next_Song( Shared_Playlist* this, Shared_cursor* cursor, Song* out )
+{
+	assert( cursor );
+	assert( out );
+	
+	if( cursor->stale || cursor->node == SHARED_NIL )
+	{
+		return false;
+	}
+	if( cursor->node >= this->header->capacity ) // slo puede pasar si se ley a medias
+	{
+		cursor->stale = true;
+		return false;
+	}
+	
+	const Shared_node* n = &this->nodes[ cursor->node ];
+	memcpy( out, &n->song, sizeof( Song ) );
+	uint32_t next = n->next;
+	if( Shared_read_retry( this, cursor->version ) )
+	{
+		cursor->stale = true;
+		return false;
+	}
+	cursor->node = next;
+	return true;
+}
+
+/**
+* @brief Copia el encabezado y las casillas usadas a memoria privada.
+*
+* El arreglo privado crece hasta las casillas usadas (no hasta la capacidad del segmento).
+*
+* @return false si lo copiado no es consistente (slo puede pasar si se ley a medias).
+*/
+static bool Snapshot( Shared_Playlist* this, Shared_header* h, Shared_node** nodes, size_t* cap )
+{
+	h->first = this->header->first;
+	h->len = this->header->len;
+	h->used = this->header->used;
+	if( h->used > this->header->capacity || h->len > h->used )
+	{
+		return false;
+	}
+	if( h->used > *cap )
+	{
+		*cap = h->used;
+		*nodes = (Shared_node*) realloc( *nodes, *cap * sizeof( Shared_node ) );
+		assert( *nodes );
+	}
+	if( h->used > 0 )
+	{
+		memcpy( *nodes, this->nodes, (size_t) h->used * sizeof( Shared_node ) );
+	}
+	return true;
+}
+
+/**
+* @brief Copia a una Playlist normal una versin consistente de la Playlist compartida.
+*
+* Las casillas se copian de un solo golpe (memcpy) y se validan una vez; los enlaces se
+* siguen en la copia privada. Si el escritor interrumpe SHARED_COPY_TRIES intentos, la
+* copia se hace con su candado tomado, as que siempre termina.
+*
+* @param this Una Playlist compartida.
+* @param other Playlist copia; se vaca antes de copiar.
+*
+* @return false si el escritor muri a media modificacin; other queda vaca.
+*/
+bool Shared_Playlist_copy( Shared_Playlist* this, Playlist* other )
+{
+	assert( this );
+	assert( other );
+	
+	Make_Playlist_Empty( other );
+	
+	Shared_header h;
+	Shared_node* nodes = NULL;
+	size_t cap = 0;
+	
+	bool ok = false;
+	for( int i = 0; i < SHARED_COPY_TRIES && !ok; ++i )
+	{
+		uint64_t v;
+		if( !Shared_read_begin( this, &v ) )
+		{
+			free( nodes );
+			return false;
+		}
+		ok = Snapshot( this, &h, &nodes, &cap ) && !Shared_read_retry( this, v );
+	}
+	if( !ok )
+	{
+		if( !Lock( this ) )
+		{
+			free( nodes );
+			return false;
+		}
+		ok = Snapshot( this, &h, &nodes, &cap );
+		Unlock( this );
+		assert( ok );
+	}
+	
+	uint32_t it = h.first;
+	for( uint64_t k = 0; k < h.len && it < h.used; ++k, it = nodes[ it ].next )
+	{
+		Song* s = &nodes[ it ].song;
+		Insert_Song_back( other, s->duration, s->name, s->artist );
+	}
+	free( nodes );
+	return true;
+}
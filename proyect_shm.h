@@ -0,0 +1,69 @@
+#ifndef PROYECT_SHM_H
+#define PROYECT_SHM_H
+
+#include <pthread.h>
+#include "proyect_playlist.h"
+
+#define SHARED_NIL UINT32_MAX // ndice nulo: hace las veces de NULL en los enlaces
+#define SHARED_SPIN_MAX 64    // Veces que un lector cede el CPU antes de esperar en el candado
+#define SHARED_COPY_TRIES 4   // Intentos sin candado de Shared_Playlist_copy
+
+typedef struct
+{
+	Song song;
+	uint32_t next;            // ndices dentro del segmento, no apuntadores
+	uint32_t prev;
+} Shared_node;
+
+typedef struct
+{
+	uint32_t magic;
+	uint32_t capacity;        // Nmero de casillas para canciones
+	uint64_t seq;             // Seqlock: impar mientras el escritor modifica
+	uint64_t len;
+	uint32_t first;
+	uint32_t last;
+	uint32_t free_head;       // Casillas liberadas, enlazadas por next
+	uint32_t used;            // Casillas tomadas alguna vez
+	pthread_mutex_t lock;     // Compartido y robusto: el escritor lo tiene mientras modifica
+} Shared_header;
+
+typedef struct
+{
+	char* name;
+	int fd;
+	bool writer;
+	size_t map_len;
+	size_t header_len;        // El encabezado ocupa sus propias pginas, mapeadas con escritura
+	Shared_header* header;
+	Shared_node* nodes;
+} Shared_Playlist;
+
+typedef struct
+{
+	uint32_t node;
+	uint64_t version;         // seq con el que empez el recorrido
+	bool stale;               // El escritor modific la Playlist durante el recorrido
+} Shared_cursor;
+
+Shared_Playlist* Shared_Playlist_create( const char name[], uint32_t capacity );
+Shared_Playlist* Shared_Playlist_attach( const char name[] );
+void Shared_Playlist_detach( Shared_Playlist** this );
+bool Shared_Playlist_unlink( const char name[] );
+
+bool Shared_Insert_Song_front( Shared_Playlist* this, int duration, char name[], char artist[] );
+bool Shared_Insert_Song_back( Shared_Playlist* this, int duration, char name[], char artist[] );
+void Shared_Erase_Song_front( Shared_Playlist* this );
+void Shared_Erase_Song_back( Shared_Playlist* this );
+void Shared_Make_Playlist_Empty( Shared_Playlist* this );
+bool Shared_Playlist_load( Shared_Playlist* this, Playlist* source );
+
+bool Shared_read_begin( Shared_Playlist* this, uint64_t* version );
+bool Shared_read_retry( Shared_Playlist* this, uint64_t version );
+
+size_t Shared_Playlist_Num_Songs( Shared_Playlist* this );
+void   Shared_First_Song( Shared_Playlist* this, Shared_cursor* cursor );
+bool   Shared_Next_Song( Shared_Playlist* this, Shared_cursor* cursor, Song* out );
+bool   Shared_Playlist_copy( Shared_Playlist* this, Playlist* other );
+
+#endif